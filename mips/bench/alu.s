@@ -0,0 +1,25 @@
+        # ALU loop benchmark
+        # Hex image uses branch offsets relative to the branch itself,
+        # matching how this simulator executes branches (no delay slots).
+	.text
+
+main:
+        lui $a0, 0x0010             # 0x00100000 iterations
+        addiu $t0, $zero, 0
+        addiu $t1, $zero, 0x1234
+        addiu $t2, $zero, 0x0765
+loop:
+        addu $t3, $t1, $t2
+        xor $t1, $t3, $t0
+        sll $t4, $t1, 3
+        srl $t5, $t3, 5
+        or $t2, $t4, $t5
+        and $t6, $t2, $t1
+        subu $t7, $t6, $t0
+        slt $t8, $t7, $t3
+        nor $t9, $t8, $t2
+        addiu $t0, $t0, 1
+        bne $t0, $a0, loop
+
+        addiu $v0, $zero, 0xa
+        syscall
@@ -0,0 +1,17 @@
+3c040010
+24080000
+24091234
+240a0765
+012a5821
+01684826
+000960c0
+000b6942
+018d5025
+01497024
+01c87823
+01ebc02a
+030ac827
+25080001
+1504fff6
+2402000a
+0000000c
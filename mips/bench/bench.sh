@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# bench.sh
+# Host-side throughput benchmark of the simulator.
+#
+# Runs every workload (*.x in this directory, except the refill handler)
+# in every execution mode and records host instructions per second, ns per
+# instruction and peak RSS.
+# Results are appended as JSON lines, one object per workload and mode,
+# tagged with the current commit so runs can be compared across commits.
+#
+# Modes naming @map run only for workloads with a symbol map beside them
+# (workload.map), for the routines -N runs natively. The translated mode
+# maps kuseg through the TLB, with refill.x (refill.s) as the handler.
+#
+# usage: bench.sh <sim binary> [results file]
+#
+
+SIM=$(cd "$(dirname "${1:-../sim/sim}")" && pwd)/$(basename "${1:-../sim/sim}")
+DIR=$(cd "$(dirname "$0")" && pwd)
+COMMIT=$(git -C "$DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)
+OUT=${2:-bench-$COMMIT.jsonl}
+
+# execution modes: name followed by simulator flags
+MODES="default -b
+stats -b -j /dev/null
+profile -b -p 0
+sampling -b -s 1000
+shared-text -b -t
+analysis -b -p 0 -C 0 -c i:16k:2:32 -c d:16k:4:32 -B all -T default
+decoupled -b -p 0 -C 0 -c i:16k:2:32 -c d:16k:4:32 -B all -T default -A
+simt -l $DIR/lanes.in
+native -b -N @map
+translated -b -V -k $DIR/refill.x"
+
+# the simulator writes dumpsim to the working directory
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+printf "%-12s %-12s %12s %10s %10s %12s\n" workload mode instructions MIPS ns/instr "peak RSS KB"
+
+for prog in "$DIR"/*.x; do
+  workload=$(basename "$prog" .x)
+  [ "$workload" = refill ] && continue
+
+  echo "$MODES" | while IFS= read -r mode; do
+    name=${mode%% *}
+    flags=${mode#* }
+
+    case "$flags" in
+      *@map*)
+        [ -f "$DIR/$workload.map" ] || continue
+        flags=$(echo "$flags" | sed "s|@map|$DIR/$workload.map|")
+        ;;
+    esac
+
+    line=$(cd "$WORK" && $SIM $flags "$prog" | grep '^Host perf :')
+    if [ -z "$line" ]; then
+      echo "$workload: $name run failed" >&2
+      continue
+    fi
+
+    # key=value pairs from the simulator's host report
+    eval "$(echo "${line#Host perf : }" | tr ' ' '\n')"
+
+    printf "%-12s %-12s %12s %10s %10s %12s\n" "$workload" "$name" \
+      "$instructions" "$mips" "$ns_per_instr" "$peak_rss_kb"
+
+    printf '{"commit": "%s", "workload": "%s", "mode": "%s", "instructions": %s, "seconds": %s, "mips": %s, "ns_per_instr": %s, "peak_rss_kb": %s}\n' \
+      "$COMMIT" "$workload" "$name" "$instructions" "$seconds" "$mips" \
+      "$ns_per_instr" "$peak_rss_kb" >> "$OUT"
+  done
+done
+
+echo "Results appended to $OUT"
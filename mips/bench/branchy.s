@@ -0,0 +1,37 @@
+        # Branch-heavy benchmark: data-dependent branches on an LCG stream
+        # Hex image uses branch offsets relative to the branch itself,
+        # matching how this simulator executes branches (no delay slots).
+	.text
+
+main:
+        lui $a0, 0x0008             # 0x00080000 iterations
+        addiu $t0, $zero, 0
+        addiu $s0, $zero, 1         # LCG state
+        addiu $s1, $zero, 0x4e6d    # LCG multiplier
+        addiu $s2, $zero, 0x3039    # LCG increment
+loop:
+        multu $s0, $s1
+        mflo $s0
+        addu $s0, $s0, $s2
+        srl $t1, $s0, 16
+        andi $t2, $t1, 1
+        beq $t2, $zero, even
+        addiu $s3, $s3, 1
+        andi $t2, $t1, 2
+        bne $t2, $zero, next
+        addiu $s4, $s4, 1
+        j next
+even:
+        andi $t2, $t1, 4
+        beq $t2, $zero, next
+        addiu $s5, $s5, 1
+next:
+        slti $t3, $t1, 0x4000
+        beq $t3, $zero, skip
+        addiu $s6, $s6, 1
+skip:
+        addiu $t0, $t0, 1
+        bne $t0, $a0, loop
+
+        addiu $v0, $zero, 0xa
+        syscall
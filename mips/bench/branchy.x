@@ -0,0 +1,26 @@
+3c040008
+24080000
+24100001
+24114e6d
+24123039
+02110019
+00008012
+02128021
+00104c02
+312a0001
+11400006
+26730001
+312a0002
+15400006
+26940001
+08100013
+312a0004
+11400002
+26b50001
+292b4000
+11600002
+26d60001
+25080001
+1504ffee
+2402000a
+0000000c
@@ -0,0 +1,84 @@
+        # Library call benchmark: a 4K memcpy, a 2K memset and a strlen,
+        # 2000 times over, for running the routines natively with -N
+        # (libcalls.map gives their entry points).
+        # Hex image uses branch offsets relative to the branch itself,
+        # matching how this simulator executes branches (no delay slots).
+	.text
+
+        j main
+
+memcpy:                             # word copy, $a2 a multiple of 4
+        move $v0, $a0
+        beq $a2, $zero, mcdone
+mcloop:
+        lw $t0, 0($a1)
+        sw $t0, 0($a0)
+        addiu $a0, $a0, 4
+        addiu $a1, $a1, 4
+        addiu $a2, $a2, -4
+        bne $a2, $zero, mcloop
+mcdone:
+        jr $ra
+
+memset:                             # word fill, $a2 a multiple of 4
+        move $v0, $a0
+        sll $t0, $a1, 8
+        or $t0, $t0, $a1
+        sll $t1, $t0, 16
+        or $t0, $t0, $t1
+        beq $a2, $zero, msdone
+msloop:
+        sw $t0, 0($a0)
+        addiu $a0, $a0, 4
+        addiu $a2, $a2, -4
+        bne $a2, $zero, msloop
+msdone:
+        jr $ra
+
+strlen:
+        move $v0, $zero
+slloop:
+        addu $t0, $a0, $v0
+        lb $t1, 0($t0)
+        beq $t1, $zero, sldone
+        addiu $v0, $v0, 1
+        j slloop
+sldone:
+        jr $ra
+
+main:
+        li $s0, 0x10000000          # source buffer
+        li $t2, 0
+fill:
+        addu $t3, $s0, $t2
+        sw $t2, 0($t3)
+        addiu $t2, $t2, 4
+        li $t4, 4096
+        bne $t2, $t4, fill
+
+        li $t1, 0x0a216948          # "Hi!\n" after the source buffer
+        sw $t1, 4096($s0)
+        sw $zero, 4100($s0)
+
+        li $s1, 2000                # repetitions
+rep:
+        li $a0, 0x10002000
+        li $a1, 0x10000000
+        li $a2, 4096
+        jal memcpy
+
+        li $a0, 0x10004000
+        li $a1, 0x41
+        li $a2, 2048
+        jal memset
+
+        li $a0, 0x10001000          # strlen, called through a register
+        li $t9, 0x400054
+        jalr $t9
+        move $s2, $v0
+
+        addiu $s1, $s1, -1
+        bne $s1, $zero, rep
+
+        li $v0, 10
+        syscall
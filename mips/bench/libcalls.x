@@ -0,0 +1,60 @@
+0810001c
+00801021
+10c00007
+8ca80000
+ac880000
+24840004
+24a50004
+24c6fffc
+14c0fffb
+03e00008
+00801021
+00054200
+01054025
+00084c00
+01094025
+10c00005
+ac880000
+24840004
+24c6fffc
+14c0fffd
+03e00008
+00001021
+00824021
+81090000
+11200003
+24420001
+08100016
+03e00008
+3c101000
+240a0000
+020a5821
+ad6a0000
+254a0004
+240c1000
+154cfffc
+3c090a21
+35296948
+ae091000
+ae001004
+241107d0
+3c041000
+34842000
+3c051000
+24061000
+0c100001
+3c041000
+34844000
+24050041
+24060800
+0c10000a
+3c041000
+34841000
+3c190040
+37390054
+0320f809
+00409021
+2631ffff
+1620ffef
+2402000a
+0000000c
@@ -0,0 +1,27 @@
+        # Load/store stream benchmark: repeatedly copy a 16K-word array
+        # Hex image uses branch offsets relative to the branch itself,
+        # matching how this simulator executes branches (no delay slots).
+	.text
+
+main:
+        lui $s0, 0x1000             # source array
+        lui $s1, 0x1001             # destination array
+        addiu $s2, $zero, 48        # passes over the array
+pass:
+        addiu $t0, $s0, 0
+        addiu $t1, $s1, 0
+        lui $t2, 0x1001             # end of source array
+copy:
+        lw $t3, 0($t0)
+        addiu $t3, $t3, 1
+        sw $t3, 0($t1)
+        sw $t3, 0($t0)
+        addiu $t0, $t0, 4
+        addiu $t1, $t1, 4
+        bne $t0, $t2, copy
+
+        addiu $s2, $s2, -1
+        bne $s2, $zero, pass
+
+        addiu $v0, $zero, 0xa
+        syscall
@@ -0,0 +1,17 @@
+3c101000
+3c111001
+24120030
+26080000
+26290000
+3c0a1001
+8d0b0000
+256b0001
+ad2b0000
+ad0b0000
+25080004
+25290004
+150afffa
+2652ffff
+1640fff5
+2402000a
+0000000c
@@ -0,0 +1,27 @@
+        # Multiply/divide-heavy kernel benchmark
+        # Hex image uses branch offsets relative to the branch itself,
+        # matching how this simulator executes branches (no delay slots).
+	.text
+
+main:
+        lui $a0, 0x0008             # 0x00080000 iterations
+        addiu $t0, $zero, 1
+        addiu $s0, $zero, 0x7777
+loop:
+        mult $t0, $s0
+        mflo $t1
+        mfhi $t2
+        multu $t1, $t0
+        mflo $t3
+        ori $t4, $t0, 1             # never divide by zero
+        divu $t3, $t4
+        mflo $t5
+        div $t1, $t4
+        mflo $t6
+        addu $s1, $s1, $t5
+        addu $s1, $s1, $t6
+        addiu $t0, $t0, 1
+        bne $t0, $a0, loop
+
+        addiu $v0, $zero, 0xa
+        syscall
@@ -0,0 +1,19 @@
+3c040008
+24080001
+24107777
+01100018
+00004812
+00005010
+01280019
+00005812
+350c0001
+016c001b
+00006812
+012c001a
+00007012
+022d8821
+022e8821
+25080001
+1504fff3
+2402000a
+0000000c
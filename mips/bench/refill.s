@@ -0,0 +1,16 @@
+        # TLB refill handler for the translated (-V) bench mode, loaded
+        # with -k. Maps the faulting 4K page pair one to one, global, valid
+        # and dirty, into a random entry. The workloads raise no other
+        # exceptions.
+	.text
+
+refill:
+        mfc0 $k0, $10                   # EntryHi, VPN2 of the faulting pair
+        srl $k0, $k0, 13
+        sll $k0, $k0, 7                 # PFN of the even page, in EntryLo position
+        ori $k0, $k0, 0x7               # dirty, valid, global
+        mtc0 $k0, $2                    # EntryLo0
+        addiu $k0, $k0, 0x40            # the odd page
+        mtc0 $k0, $3                    # EntryLo1
+        tlbwr
+        eret
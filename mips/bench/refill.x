@@ -0,0 +1,9 @@
+401a5000
+001ad342
+001ad1c0
+375a0007
+409a1000
+275a0040
+409a1800
+42000006
+42000018
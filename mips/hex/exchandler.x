@@ -0,0 +1,14 @@
+401a6800
+335a007c
+3c1b1008
+037ad821
+8f7a0000
+275a0001
+af7a0000
+3c1b1008
+401a4000
+af7a0080
+401a7000
+275a0004
+409a7000
+42000018
@@ -0,0 +1,27 @@
+3c031000
+3c0a8000
+2548ffff
+24090001
+240b0055
+01095820
+240c0055
+210c0001
+240d0055
+01496822
+01097021
+ac680000
+240f0055
+8c6f0002
+846f0001
+a4680003
+8c780000
+fc000000
+46000020
+3c041008
+8c900030
+8c910010
+8c920014
+8c930028
+8c940080
+2402000a
+0000000c
@@ -0,0 +1,61 @@
+3c083fc0
+44880000
+3c094020
+44890800
+3c0ac020
+448a1000
+3c0b7fc0
+448b1800
+46010100
+44102000
+46010142
+44112800
+240c0001
+448c3000
+468031a1
+240c0003
+448c4000
+46804221
+240d0002
+44cdf800
+46283283
+44125000
+46000b24
+44146000
+240d0003
+44cdf800
+46283283
+44135000
+46001324
+44156000
+44c0f800
+46000b0c
+44166000
+24170000
+4601003c
+45000002
+36f70001
+46010032
+45010002
+36f70002
+46001833
+45000002
+36f70004
+4601033c
+45010002
+36f70008
+450c0002
+36f70010
+46001832
+4458f800
+4600183a
+4459f800
+44c0f800
+3c0e7ff0
+448e7800
+240e0001
+448e7000
+46267032
+444ff800
+2402000a
+0000000c
@@ -0,0 +1,39 @@
+3c021234
+34425678
+2403fff0
+2404ffff
+2405fff9
+24060006
+70a63802
+70424002
+70494820
+700a5020
+706b5821
+708c6021
+7c4d5a00
+7c4ef800
+00047821
+7c4f5904
+00038021
+7c50f804
+00038821
+7c511a04
+24120080
+7c129c20
+24147fff
+26940001
+7c14ae20
+7c02b420
+7c02b8a0
+24180001
+0040c00a
+24190001
+0040c80b
+0022d202
+0022d802
+241c0024
+0382e046
+0002e846
+0042f00b
+2402000a
+0000000c
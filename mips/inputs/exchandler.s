@@ -0,0 +1,22 @@
+# Exception handler for exctest (load with -k)
+# Counts each exception by ExcCode in a table at 0x10080000, keeps the
+# last BadVAddr at 0x10080080, and returns past the faulting instruction.
+# Only $k0 and $k1 are used.
+	.text
+handler:
+        mfc0    $k0, $13                # Cause
+        andi    $k0, $k0, 0x7c          # ExcCode * 4
+        lui     $k1, 0x1008
+        addu    $k1, $k1, $k0
+        lw      $k0, 0($k1)
+        addiu   $k0, $k0, 1
+        sw      $k0, 0($k1)             # count[ExcCode]++
+
+        lui     $k1, 0x1008
+        mfc0    $k0, $8
+        sw      $k0, 0x80($k1)          # last BadVAddr
+
+        mfc0    $k0, $14
+        addiu   $k0, $k0, 4
+        mtc0    $k0, $14                # resume after the faulting instruction
+        eret
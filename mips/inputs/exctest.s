@@ -0,0 +1,44 @@
+# Exceptions
+# Arithmetic overflow, misaligned loads and stores, and reserved
+# instructions, handled by exchandler (run with -k hex/exchandler.x).
+# Faulting instructions must leave their destination untouched. The
+# handler's counts are copied into registers at the end; expected values
+# are noted beside each instruction.
+	.text
+main:
+        lui     $3, 0x1000              # data
+        lui     $10, 0x8000             # $10 = 0x80000000
+        addiu   $8, $10, -1             # $8  = 0x7fffffff
+        addiu   $9, $zero, 1
+
+        # overflow
+        addiu   $11, $zero, 0x55
+        add     $11, $8, $9             # Ov, $11 = 0x55
+        addiu   $12, $zero, 0x55
+        addi    $12, $8, 1              # Ov, $12 = 0x55
+        addiu   $13, $zero, 0x55
+        sub     $13, $10, $9            # Ov, $13 = 0x55
+        addu    $14, $8, $9             # $14 = 0x80000000, no trap
+
+        # misaligned accesses
+        sw      $8, 0($3)
+        addiu   $15, $zero, 0x55
+        lw      $15, 2($3)              # AdEL, $15 = 0x55
+        lh      $15, 1($3)              # AdEL, $15 = 0x55
+        sh      $8, 3($3)               # AdES, memory unchanged
+        lw      $24, 0($3)              # $24 = 0x7fffffff
+
+        # reserved instructions
+        .word   0xfc000000              # opcode 63
+        .word   0x46000020              # cvt.s.s $f0, $f0
+
+        # the handler's counts
+        lui     $4, 0x1008
+        lw      $16, 0x30($4)           # $16 = 3, Ov (12)
+        lw      $17, 0x10($4)           # $17 = 2, AdEL (4)
+        lw      $18, 0x14($4)           # $18 = 1, AdES (5)
+        lw      $19, 0x28($4)           # $19 = 2, RI (10)
+        lw      $20, 0x80($4)           # $20 = 0x10000003, BadVAddr of the sh
+
+        addiu   $v0, $zero, 0xa
+        syscall
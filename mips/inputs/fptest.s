@@ -0,0 +1,82 @@
+# Floating point
+# Single and double arithmetic, conversions under each rounding mode,
+# compares with bc1t/bc1f on several condition codes, and the FCSR cause
+# and flag bits compares set on NaN operands. Expected values are noted
+# beside each instruction.
+	.text
+main:
+        lui     $8, 0x3fc0
+        mtc1    $8, $f0                 # $f0 = 1.5
+        lui     $9, 0x4020
+        mtc1    $9, $f1                 # $f1 = 2.5
+        lui     $10, 0xc020
+        mtc1    $10, $f2                # $f2 = -2.5
+        lui     $11, 0x7fc0
+        mtc1    $11, $f3                # $f3 = quiet NaN
+
+        # single arithmetic
+        add.s   $f4, $f0, $f1
+        mfc1    $16, $f4                # $16 = 0x40800000 (4.0)
+        mul.s   $f5, $f0, $f1
+        mfc1    $17, $f5                # $17 = 0x40700000 (3.75)
+
+        # 1/3 in double: the last bit depends on the rounding mode
+        addiu   $12, $zero, 1
+        mtc1    $12, $f6
+        cvt.d.w $f6, $f6                # $f6 = 1.0
+        addiu   $12, $zero, 3
+        mtc1    $12, $f8
+        cvt.d.w $f8, $f8                # $f8 = 3.0
+        addiu   $13, $zero, 2
+        ctc1    $13, $31                # round towards +infinity
+        div.d   $f10, $f6, $f8
+        mfc1    $18, $f10               # $18 = 0x55555556
+        cvt.w.s $f12, $f1
+        mfc1    $20, $f12               # $20 = 3
+        addiu   $13, $zero, 3
+        ctc1    $13, $31                # round towards -infinity
+        div.d   $f10, $f6, $f8
+        mfc1    $19, $f10               # $19 = 0x55555555
+        cvt.w.s $f12, $f2
+        mfc1    $21, $f12               # $21 = -3
+        ctc1    $zero, $31              # round to nearest
+        round.w.s $f12, $f1
+        mfc1    $22, $f12               # $22 = 2, ties go to even, Inexact
+
+        # compares and branches on condition codes 0 and 3
+        addiu   $23, $zero, 0
+        c.lt.s  $f0, $f1
+        bc1f    lt_false
+        ori     $23, $23, 1
+lt_false:
+        c.eq.s  $f0, $f1
+        bc1t    eq_true
+        ori     $23, $23, 2
+eq_true:
+        c.ueq.s $f3, $f0                # unordered counts as equal
+        bc1f    ueq_false
+        ori     $23, $23, 4
+ueq_false:
+        c.lt.s  3, $f0, $f1
+        bc1t    0, cc0_true             # cc 0 still holds the ueq result
+        ori     $23, $23, 8
+cc0_true:
+        bc1f    3, lt3_false
+        ori     $23, $23, 16            # $23 = 0x17
+lt3_false:
+
+        # NaN operands: quiet compares only raise Invalid for signalling NaNs
+        c.eq.s  $f3, $f0
+        cfc1    $24, $31                # $24 = 0x08000004, cc 3 and the Inexact flag
+        c.seq.s $f3, $f0
+        cfc1    $25, $31                # $25 = 0x08010044, Invalid cause and flag
+        ctc1    $zero, $31
+        lui     $14, 0x7ff0
+        mtc1    $14, $f15
+        addiu   $14, $zero, 1
+        mtc1    $14, $f14               # $f14 = signalling NaN (double)
+        c.eq.d  $f14, $f6
+        cfc1    $15, $31                # $15 = 0x00010040, cc 3 cleared with FCSR
+
+        addiu   $v0, $zero, 0xa
+        syscall
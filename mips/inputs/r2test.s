@@ -0,0 +1,59 @@
+# MIPS32 release 2 instructions
+# mul, clz, clo, ext, ins, seb, seh, wsbh, movz, movn, rotr and rotrv,
+# including their edge cases. Expected register values are noted beside
+# each instruction.
+	.text
+main:
+        lui     $2, 0x1234
+        ori     $2, $2, 0x5678          # $2  = 0x12345678 until the exit
+        addiu   $3, $zero, -16          # $3  = 0xfffffff0
+        addiu   $4, $zero, -1           # $4  = 0xffffffff
+
+        # mul keeps the low word of the signed product
+        addiu   $5, $zero, -7
+        addiu   $6, $zero, 6
+        mul     $7, $5, $6              # $7  = 0xffffffd6 (-42)
+        mul     $8, $2, $2              # $8  = 0x1df4d840
+
+        # leading zeros and ones
+        clz     $9, $2                  # $9  = 3
+        clz     $10, $zero              # $10 = 32
+        clo     $11, $3                 # $11 = 28
+        clo     $12, $4                 # $12 = 32
+
+        # bit fields
+        ext     $13, $2, 8, 12          # $13 = 0x456
+        ext     $14, $2, 0, 32          # $14 = 0x12345678
+        addu    $15, $zero, $4
+        ins     $15, $2, 4, 8           # $15 = 0xfffff78f
+        addu    $16, $zero, $3
+        ins     $16, $2, 0, 32          # $16 = 0x12345678
+        # ins with msb 3 below lsb 8 is unpredictable, rt stays 0xfffffff0
+        addu    $17, $zero, $3
+        .word   0x7c511a04              # ins $17, $2, lsb 8, msb 3
+
+        # sign extension and byte swapping
+        addiu   $18, $zero, 0x80
+        seb     $19, $18                # $19 = 0xffffff80
+        addiu   $20, $zero, 0x7fff
+        addiu   $20, $20, 1             # $20 = 0x00008000
+        seh     $21, $20                # $21 = 0xffff8000
+        seb     $22, $2                 # $22 = 0x00000078
+        wsbh    $23, $2                 # $23 = 0x34127856
+
+        # conditional moves
+        addiu   $24, $zero, 1
+        movz    $24, $2, $zero          # $24 = 0x12345678
+        addiu   $25, $zero, 1
+        movn    $25, $2, $zero          # $25 = 1
+
+        # rotates, including by 0
+        rotr    $26, $2, 8              # $26 = 0x78123456
+        rotr    $27, $2, 0              # $27 = 0x12345678
+        addiu   $28, $zero, 36          # only the low 5 bits count
+        rotrv   $28, $2, $28            # $28 = 0x81234567
+        rotrv   $29, $2, $zero          # $29 = 0x12345678
+        movn    $30, $2, $2             # $30 = 0x12345678
+
+        addiu   $v0, $zero, 0xa
+        syscall
@@ -0,0 +1,371 @@
+/*
+ * bpred.c
+ * Branch predictor models and their accuracy statistics.
+ *
+ * Every enabled model sees the same branch stream, so one run compares
+ * them all. Direction predictors are consulted and trained from the
+ * conditional branch handlers; the return address stack is pushed by the
+ * call instructions and checked by jr $ra.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shell.h"
+#include "stats.h"
+#include "disasm.h"
+#include "bpred.h"
+
+int BPRED_MODELS;
+int BPRED_MISPREDICTED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define BPRED_SLOTS (MEM_TEXT_SIZE >> 2)
+
+static const char *MODEL_NAMES[BPRED_COUNT] = {
+	"static", "bimodal", "gshare", "tage", "ras"
+};
+
+// predictions and mispredictions per model
+static uint64_t predictions[BPRED_COUNT];
+static uint64_t mispredicts[BPRED_COUNT];
+
+// executions and mispredictions by PC, indexed by (PC - MEM_TEXT_START) >> 2
+static uint32_t *pc_branches;
+static uint32_t *pc_mispredicts[BPRED_COUNT];
+
+// bimodal: 2-bit saturating counters, taken when >= 2
+#define BIMODAL_BITS 12
+static uint8_t bimodal[1 << BIMODAL_BITS];
+
+// gshare: 2-bit counters indexed by PC xor global history
+#define GSHARE_BITS 14
+static uint8_t gshare[1 << GSHARE_BITS];
+static uint32_t gshare_history;
+
+// TAGE-lite: bimodal base and tagged tables with geometric history lengths
+#define TAGE_TABLES     4
+#define TAGE_INDEX_BITS 10
+#define TAGE_TAG_BITS   8
+#define TAGE_BASE_BITS  12
+#define TAGE_RESET      (1 << 18)   // branches between usefulness decays
+
+typedef struct {
+	int8_t ctr;       // 3-bit signed counter, taken when >= 0
+	uint8_t tag;
+	uint8_t valid;    // allocated, so tag 0 doesn't match an empty entry
+	uint8_t useful;   // 2-bit usefulness
+} TageEntry;
+
+static const int TAGE_HISTORY[TAGE_TABLES] = { 5, 12, 27, 64 };
+static TageEntry tage[TAGE_TABLES][1 << TAGE_INDEX_BITS];
+static uint8_t tage_base[1 << TAGE_BASE_BITS];
+static uint64_t tage_history;
+static uint32_t tage_branches;
+
+// return address stack, circular so deep recursion overwrites the oldest
+#define RAS_DEPTH 16
+static uint32_t ras[RAS_DEPTH];
+static int ras_top;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static uint8_t counter_update(uint8_t ctr, int taken) {
+	if (taken) {
+		return ctr < 3 ? ctr + 1 : 3;
+	}
+	return ctr > 0 ? ctr - 1 : 0;
+}
+
+static void record(int model, uint32_t slot, int mispredicted) {
+	predictions[model]++;
+	if (mispredicted) {
+		mispredicts[model]++;
+		if (slot < BPRED_SLOTS) {
+			pc_mispredicts[model][slot]++;
+		}
+	}
+}
+
+// fold the low length bits of the history down to bits wide
+static uint32_t tage_fold(uint64_t history, int length, int bits) {
+	uint32_t folded = 0;
+
+	if (length < 64) {
+		history &= (1ULL << length) - 1;
+	}
+	for (int i = 0; i < length; i += bits) {
+		folded ^= (uint32_t) (history >> i);
+	}
+	return folded & ((1U << bits) - 1);
+}
+
+static uint32_t tage_index(int table, uint32_t pc) {
+	uint32_t h = tage_fold(tage_history, TAGE_HISTORY[table], TAGE_INDEX_BITS);
+	return ((pc >> 2) ^ (pc >> (2 + TAGE_INDEX_BITS)) ^ h) & ((1 << TAGE_INDEX_BITS) - 1);
+}
+
+static uint8_t tage_tag(int table, uint32_t pc) {
+	uint32_t h = tage_fold(tage_history, TAGE_HISTORY[table], TAGE_TAG_BITS);
+	uint32_t h2 = tage_fold(tage_history, TAGE_HISTORY[table], TAGE_TAG_BITS - 1);
+	return (uint8_t) ((pc >> 2) ^ h ^ (h2 << 1));
+}
+
+/*
+ * tage_predict
+ * Predict with the longest matching tagged table (or the base), train, and
+ * return the prediction.
+ */
+static int tage_predict(uint32_t pc, int taken) {
+	uint32_t index[TAGE_TABLES];
+	uint8_t tag[TAGE_TABLES];
+	int provider = -1, alt = -1;
+
+	for (int t = TAGE_TABLES - 1; t >= 0; t--) {
+		index[t] = tage_index(t, pc);
+		tag[t] = tage_tag(t, pc);
+		if (tage[t][index[t]].valid && tage[t][index[t]].tag == tag[t]) {
+			if (provider < 0) {
+				provider = t;
+			} else if (alt < 0) {
+				alt = t;
+			}
+		}
+	}
+
+	uint8_t *base = &tage_base[(pc >> 2) & ((1 << TAGE_BASE_BITS) - 1)];
+	int base_pred = *base >= 2;
+	int alt_pred = alt >= 0 ? tage[alt][index[alt]].ctr >= 0 : base_pred;
+	int pred = base_pred;
+
+	if (provider >= 0) {
+		TageEntry *e = &tage[provider][index[provider]];
+		pred = e->ctr >= 0;
+
+		// usefulness tracks whether the provider beat the alternate
+		if (pred != alt_pred) {
+			if (pred == taken && e->useful < 3) {
+				e->useful++;
+			} else if (pred != taken && e->useful > 0) {
+				e->useful--;
+			}
+		}
+
+		if (taken && e->ctr < 3) {
+			e->ctr++;
+		} else if (!taken && e->ctr > -4) {
+			e->ctr--;
+		}
+	} else {
+		*base = counter_update(*base, taken);
+	}
+
+	// on a misprediction, allocate in a longer history table
+	if (pred != taken && provider < TAGE_TABLES - 1) {
+		int allocated = 0;
+		for (int t = provider + 1; t < TAGE_TABLES; t++) {
+			TageEntry *e = &tage[t][index[t]];
+			if (e->useful == 0) {
+				e->tag = tag[t];
+				e->valid = 1;
+				e->ctr = taken ? 0 : -1;
+				allocated = 1;
+				break;
+			}
+		}
+		if (!allocated) {
+			for (int t = provider + 1; t < TAGE_TABLES; t++) {
+				if (tage[t][index[t]].useful > 0) {
+					tage[t][index[t]].useful--;
+				}
+			}
+		}
+	}
+
+	// periodically decay usefulness so stale entries can be replaced
+	if (++tage_branches == TAGE_RESET) {
+		tage_branches = 0;
+		for (int t = 0; t < TAGE_TABLES; t++) {
+			for (int i = 0; i < (1 << TAGE_INDEX_BITS); i++) {
+				tage[t][i].useful >>= 1;
+			}
+		}
+	}
+
+	tage_history = (tage_history << 1) | (taken != 0);
+	return pred;
+}
+
+// sort slots by descending mispredictions of the model being reported
+static const uint32_t *sort_counts;
+
+static int compare_slots(const void *a, const void *b) {
+	uint32_t ca = sort_counts[*(const uint32_t *) a];
+	uint32_t cb = sort_counts[*(const uint32_t *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Predictor Interface
+	See module header file (bpred.h) for detailed function comments.
+*/
+
+int bpred_configure(const char *spec) {
+	char buf[128];
+
+	snprintf(buf, sizeof(buf), "%s", spec);
+	for (char *name = strtok(buf, ","); name; name = strtok(NULL, ",")) {
+		int model;
+
+		if (!strcmp(name, "all")) {
+			BPRED_MODELS = (1 << BPRED_COUNT) - 1;
+			continue;
+		}
+		for (model = 0; model < BPRED_COUNT; model++) {
+			if (!strcmp(name, MODEL_NAMES[model])) {
+				break;
+			}
+		}
+		if (model == BPRED_COUNT) {
+			return -1;
+		}
+		BPRED_MODELS |= 1 << model;
+	}
+
+	if (pc_branches == NULL) {
+		pc_branches = calloc(BPRED_SLOTS, sizeof(uint32_t));
+	}
+	for (int model = 0; model < BPRED_COUNT; model++) {
+		if ((BPRED_MODELS & (1 << model)) && pc_mispredicts[model] == NULL) {
+			pc_mispredicts[model] = calloc(BPRED_SLOTS, sizeof(uint32_t));
+		}
+	}
+
+	// counters start weakly not taken
+	memset(bimodal, 1, sizeof(bimodal));
+	memset(gshare, 1, sizeof(gshare));
+	memset(tage_base, 1, sizeof(tage_base));
+	return 0;
+}
+
+void bpred_branch(uint32_t pc, uint32_t target, int taken) {
+	uint32_t slot = (pc - MEM_TEXT_START) >> 2;
+	int pred;
+
+	if (slot < BPRED_SLOTS) {
+		pc_branches[slot]++;
+	}
+
+	// models are ordered by sophistication, the last enabled one decides
+	BPRED_MISPREDICTED = taken;
+
+	if (BPRED_MODELS & (1 << BPRED_STATIC)) {
+		pred = target < pc;
+		record(BPRED_STATIC, slot, pred != taken);
+		BPRED_MISPREDICTED = pred != taken;
+	}
+
+	if (BPRED_MODELS & (1 << BPRED_BIMODAL)) {
+		uint8_t *ctr = &bimodal[(pc >> 2) & ((1 << BIMODAL_BITS) - 1)];
+		pred = *ctr >= 2;
+		*ctr = counter_update(*ctr, taken);
+		record(BPRED_BIMODAL, slot, pred != taken);
+		BPRED_MISPREDICTED = pred != taken;
+	}
+
+	if (BPRED_MODELS & (1 << BPRED_GSHARE)) {
+		uint8_t *ctr = &gshare[((pc >> 2) ^ gshare_history) & ((1 << GSHARE_BITS) - 1)];
+		pred = *ctr >= 2;
+		*ctr = counter_update(*ctr, taken);
+		gshare_history = (gshare_history << 1) | (taken != 0);
+		record(BPRED_GSHARE, slot, pred != taken);
+		BPRED_MISPREDICTED = pred != taken;
+	}
+
+	if (BPRED_MODELS & (1 << BPRED_TAGE)) {
+		pred = tage_predict(pc, taken);
+		record(BPRED_TAGE, slot, pred != taken);
+		BPRED_MISPREDICTED = pred != taken;
+	}
+}
+
+void bpred_call(uint32_t return_addr) {
+	ras_top = (ras_top + 1) % RAS_DEPTH;
+	ras[ras_top] = return_addr;
+}
+
+void bpred_return(uint32_t pc, uint32_t target) {
+	uint32_t slot = (pc - MEM_TEXT_START) >> 2;
+	uint32_t pred = ras[ras_top];
+
+	ras_top = (ras_top + RAS_DEPTH - 1) % RAS_DEPTH;
+
+	BPRED_MISPREDICTED = 1;
+	if (BPRED_MODELS & (1 << BPRED_RAS)) {
+		BPRED_MISPREDICTED = pred != target;
+		if (slot < BPRED_SLOTS) {
+			pc_branches[slot]++;
+		}
+		record(BPRED_RAS, slot, pred != target);
+	}
+}
+
+void bpred_report(FILE *out, int top_n) {
+	uint64_t instructions = stats_instructions();
+	char text[64];
+
+	if (!BPRED_MODELS) {
+		return;
+	}
+
+	fprintf(out, "\nBranch prediction (%llu instructions) :\n",
+		(unsigned long long) instructions);
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  %-8s  %12s  %12s  %8s  %8s\n", "model", "predictions",
+		"mispredicts", "accuracy", "MPKI");
+	for (int model = 0; model < BPRED_COUNT; model++) {
+		if (!(BPRED_MODELS & (1 << model))) {
+			continue;
+		}
+		fprintf(out, "  %-8s  %12llu  %12llu  %7.2f%%  %8.3f\n", MODEL_NAMES[model],
+			(unsigned long long) predictions[model],
+			(unsigned long long) mispredicts[model],
+			predictions[model] ? 100.0 - 100.0 * mispredicts[model] / predictions[model] : 0.0,
+			instructions ? 1000.0 * mispredicts[model] / instructions : 0.0);
+	}
+
+	uint32_t *slots = malloc(sizeof(uint32_t) * BPRED_SLOTS);
+	for (int model = 0; model < BPRED_COUNT; model++) {
+		uint32_t n = 0;
+
+		if (!(BPRED_MODELS & (1 << model))) {
+			continue;
+		}
+		for (uint32_t slot = 0; slot < BPRED_SLOTS; slot++) {
+			if (pc_mispredicts[model][slot]) {
+				slots[n++] = slot;
+			}
+		}
+		sort_counts = pc_mispredicts[model];
+		qsort(slots, n, sizeof(uint32_t), compare_slots);
+
+		fprintf(out, "Mispredicts by PC (%s):\n", MODEL_NAMES[model]);
+		for (uint32_t i = 0; i < n && i < (uint32_t) top_n; i++) {
+			uint32_t pc = MEM_TEXT_START + (slots[i] << 2);
+			uint32_t count = pc_mispredicts[model][slots[i]];
+			disasm(mem_read_32(pc), pc, text, sizeof(text));
+			fprintf(out, "  0x%08x  %10u / %10u  %6.2f%%  MPKI %8.3f  %s\n", pc, count,
+				pc_branches[slots[i]], 100.0 * count / pc_branches[slots[i]],
+				instructions ? 1000.0 * count / instructions : 0.0, text);
+		}
+	}
+	free(slots);
+	fprintf(out, "\n");
+}
@@ -0,0 +1,60 @@
+/*
+ * bpred.h
+ * Branch predictor models and their accuracy statistics.
+ */
+
+#ifndef __BPRED_H
+#define __BPRED_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// predictor models, each bit of BPRED_MODELS enables one
+#define BPRED_STATIC  0   // backward taken, forward not taken
+#define BPRED_BIMODAL 1   // 2-bit counters indexed by PC
+#define BPRED_GSHARE  2   // 2-bit counters indexed by PC xor global history
+#define BPRED_TAGE    3   // bimodal base plus tagged geometric history tables
+#define BPRED_RAS     4   // return address stack for jal/jalr and jr $ra
+#define BPRED_COUNT   5
+
+// enabled models, one bit per model
+extern int BPRED_MODELS;
+
+// whether the last branch or return was mispredicted, by the most elaborate
+// enabled model (a direction-less run predicts not taken)
+extern int BPRED_MISPREDICTED;
+
+/*
+ * bpred_configure
+ * Enable the models named in a comma separated list (static, bimodal,
+ * gshare, tage, ras or all). Returns 0 on success, -1 on an unknown name.
+ */
+int bpred_configure(const char *spec);
+
+/*
+ * bpred_branch
+ * Run every enabled direction predictor on the conditional branch at pc,
+ * then train it with the actual outcome.
+ */
+void bpred_branch(uint32_t pc, uint32_t target, int taken);
+
+/*
+ * bpred_call
+ * Push a return address on the return address stack.
+ */
+void bpred_call(uint32_t return_addr);
+
+/*
+ * bpred_return
+ * Pop the return address stack and check it against the actual target.
+ */
+void bpred_return(uint32_t pc, uint32_t target);
+
+/*
+ * bpred_report
+ * Print mispredictions per kilo-instruction for each enabled model, overall
+ * and for the top_n branch PCs by mispredictions.
+ */
+void bpred_report(FILE *out, int top_n);
+
+#endif // __BPRED_H
@@ -0,0 +1,278 @@
+/*
+ * cache.c
+ * Configurable L1 instruction/data cache model.
+ *
+ * Only tags are modelled (data always comes from main memory). Tags and
+ * their valid bit share one word, and each set keeps its replacement state
+ * in a single 64-bit word, so lookups touch two small arrays.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shell.h"
+#include "cache.h"
+#include "disasm.h"
+
+Cache ICACHE = { .name = "L1I" };
+Cache DCACHE = { .name = "L1D" };
+
+#define TEXT_SLOTS (MEM_TEXT_SIZE >> 2)
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static int log2_exact(uint32_t value) {
+	int bits = 0;
+
+	if (value == 0 || (value & (value - 1))) {
+		return -1;
+	}
+	while ((1U << bits) != value) {
+		bits++;
+	}
+	return bits;
+}
+
+// parse a size with optional k/m suffix
+static uint32_t parse_size(const char *text) {
+	char *end;
+	uint32_t value = (uint32_t) strtoul(text, &end, 0);
+
+	if (*end == 'k' || *end == 'K') {
+		value <<= 10;
+	} else if (*end == 'm' || *end == 'M') {
+		value <<= 20;
+	}
+	return value;
+}
+
+static const char *POLICY_NAMES[] = { "lru", "plru", "random" };
+
+// miss counters being sorted by cache_report
+static const uint32_t *sort_misses;
+
+// sort slots by descending miss count
+static int compare_slots(const void *a, const void *b) {
+	uint32_t ca = sort_misses[*(const uint32_t *) a];
+	uint32_t cb = sort_misses[*(const uint32_t *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Replacement Policies
+*/
+
+// LRU: 4-bit rank per way, 0 is most recently used
+static uint32_t lru_rank(uint64_t state, uint32_t way) {
+	return (state >> (way * 4)) & 0xF;
+}
+
+static uint64_t lru_touch(uint64_t state, uint32_t assoc, uint32_t way) {
+	uint32_t rank = lru_rank(state, way);
+
+	// every way more recent than the touched one ages by one
+	for (uint32_t w = 0; w < assoc; w++) {
+		if (lru_rank(state, w) < rank) {
+			state += 1ULL << (w * 4);
+		}
+	}
+	return state & ~(0xFULL << (way * 4));
+}
+
+static uint32_t lru_victim(uint64_t state, uint32_t assoc) {
+	for (uint32_t w = 0; w < assoc; w++) {
+		if (lru_rank(state, w) == assoc - 1) {
+			return w;
+		}
+	}
+	return 0;
+}
+
+// tree PLRU: node n (1-based heap order) is bit n, set means "victim is right"
+static uint64_t plru_touch(uint64_t state, uint32_t assoc, uint32_t way) {
+	uint32_t node = 1;
+
+	for (uint32_t half = assoc >> 1; half; half >>= 1) {
+		int right = (way & half) != 0;
+		// point away from the touched way
+		state = right ? (state & ~(1ULL << node)) : (state | (1ULL << node));
+		node = node * 2 + right;
+	}
+	return state;
+}
+
+static uint32_t plru_victim(uint64_t state, uint32_t assoc) {
+	uint32_t node = 1;
+
+	while (node < assoc) {
+		node = node * 2 + ((state >> node) & 1);
+	}
+	return node - assoc;
+}
+
+/* ----------------------------------------------------------------------------
+	Cache Interface
+	See module header file (cache.h) for detailed function comments.
+*/
+
+int cache_configure(const char *spec) {
+	char buf[128], policy[16] = "lru";
+	char kind, size[32];
+	uint32_t assoc, line;
+	Cache *cache;
+
+	snprintf(buf, sizeof(buf), "%s", spec);
+	if (sscanf(buf, "%c:%31[^:]:%u:%u:%15s", &kind, size, &assoc, &line, policy) < 4) {
+		return -1;
+	}
+
+	if (kind == 'i' || kind == 'I') {
+		cache = &ICACHE;
+	} else if (kind == 'd' || kind == 'D') {
+		cache = &DCACHE;
+	} else {
+		return -1;
+	}
+
+	cache->policy = -1;
+	for (int p = 0; p < 3; p++) {
+		if (!strcmp(policy, POLICY_NAMES[p])) {
+			cache->policy = p;
+		}
+	}
+
+	cache->size  = parse_size(size);
+	cache->assoc = assoc;
+	cache->line  = line;
+	if (cache->policy < 0 || assoc == 0 || assoc > CACHE_MAX_ASSOC || line < 4 ||
+			log2_exact(assoc) < 0 || cache->size % (assoc * line)) {
+		return -1;
+	}
+
+	cache->sets      = cache->size / (assoc * line);
+	cache->line_bits = log2_exact(line);
+	cache->set_bits  = log2_exact(cache->sets);
+	if (cache->line_bits < 0 || cache->set_bits < 0) {
+		return -1;
+	}
+
+	cache->tags = calloc(cache->sets * assoc, sizeof(uint32_t));
+	cache->repl = calloc(cache->sets, sizeof(uint64_t));
+	cache->pc_accesses = calloc(TEXT_SLOTS, sizeof(uint32_t));
+	cache->pc_misses   = calloc(TEXT_SLOTS, sizeof(uint32_t));
+	cache->random = 0x2545F491;
+
+	// LRU ranks start as a permutation of the ways
+	if (cache->policy == CACHE_LRU) {
+		for (uint32_t set = 0; set < cache->sets; set++) {
+			for (uint32_t w = 0; w < assoc; w++) {
+				cache->repl[set] |= (uint64_t) w << (w * 4);
+			}
+		}
+	}
+
+	cache->enabled = 1;
+	return 0;
+}
+
+int cache_access(Cache *cache, uint32_t address, uint32_t pc) {
+	uint32_t block = address >> cache->line_bits;
+	uint32_t set   = block & (cache->sets - 1);
+	uint32_t tag   = ((block >> cache->set_bits) << 1) | 1;
+	uint32_t *ways = &cache->tags[set * cache->assoc];
+	uint32_t slot  = (pc - MEM_TEXT_START) >> 2;
+	uint32_t way;
+	int hit = 0;
+
+	for (way = 0; way < cache->assoc; way++) {
+		if (ways[way] == tag) {
+			hit = 1;
+			break;
+		}
+	}
+
+	if (!hit) {
+		// fill an invalid way if there is one, otherwise evict
+		for (way = 0; way < cache->assoc && (ways[way] & 1); way++);
+
+		if (way == cache->assoc) {
+			switch (cache->policy) {
+			case CACHE_LRU:
+				way = lru_victim(cache->repl[set], cache->assoc);
+				break;
+			case CACHE_PLRU:
+				way = plru_victim(cache->repl[set], cache->assoc);
+				break;
+			default:
+				cache->random ^= cache->random << 13;
+				cache->random ^= cache->random >> 17;
+				cache->random ^= cache->random << 5;
+				way = cache->random & (cache->assoc - 1);
+				break;
+			}
+		}
+		ways[way] = tag;
+	}
+
+	if (cache->policy == CACHE_LRU) {
+		cache->repl[set] = lru_touch(cache->repl[set], cache->assoc, way);
+	} else if (cache->policy == CACHE_PLRU) {
+		cache->repl[set] = plru_touch(cache->repl[set], cache->assoc, way);
+	}
+
+	if (hit) {
+		cache->hits++;
+	} else {
+		cache->misses++;
+	}
+
+	if (slot < TEXT_SLOTS) {
+		cache->pc_accesses[slot]++;
+		cache->pc_misses[slot] += !hit;
+	}
+
+	return hit;
+}
+
+void cache_report(Cache *cache, FILE *out, int top_n) {
+	uint64_t accesses = cache->hits + cache->misses;
+	char text[64];
+
+	if (!cache->enabled) {
+		return;
+	}
+
+	fprintf(out, "\n%s cache (%u bytes, %u-way, %u-byte lines, %u sets, %s) :\n",
+		cache->name, cache->size, cache->assoc, cache->line, cache->sets,
+		POLICY_NAMES[cache->policy]);
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "Accesses  : %llu\n", (unsigned long long) accesses);
+	fprintf(out, "Hits      : %llu\n", (unsigned long long) cache->hits);
+	fprintf(out, "Misses    : %llu\n", (unsigned long long) cache->misses);
+	fprintf(out, "Miss rate : %.2f%%\n", accesses ? 100.0 * cache->misses / accesses : 0.0);
+
+	uint32_t n = 0;
+	uint32_t *slots = malloc(sizeof(uint32_t) * TEXT_SLOTS);
+	for (uint32_t slot = 0; slot < TEXT_SLOTS; slot++) {
+		if (cache->pc_misses[slot]) {
+			slots[n++] = slot;
+		}
+	}
+	sort_misses = cache->pc_misses;
+	qsort(slots, n, sizeof(uint32_t), compare_slots);
+
+	fprintf(out, "Misses by PC:\n");
+	for (uint32_t i = 0; i < n && i < (uint32_t) top_n; i++) {
+		uint32_t pc = MEM_TEXT_START + (slots[i] << 2);
+		disasm(mem_read_32(pc), pc, text, sizeof(text));
+		fprintf(out, "  0x%08x  %10u misses / %10u accesses  %6.2f%%  %s\n", pc,
+			cache->pc_misses[slots[i]], cache->pc_accesses[slots[i]],
+			100.0 * cache->pc_misses[slots[i]] / cache->pc_accesses[slots[i]], text);
+	}
+	fprintf(out, "\n");
+	free(slots);
+}
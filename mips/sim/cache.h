@@ -0,0 +1,73 @@
+/*
+ * cache.h
+ * Configurable L1 instruction/data cache model.
+ */
+
+#ifndef __CACHE_H
+#define __CACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "shell.h"
+
+// replacement policies
+#define CACHE_LRU    0
+#define CACHE_PLRU   1
+#define CACHE_RANDOM 2
+
+// largest associativity (LRU ranks are packed 4 bits per way)
+#define CACHE_MAX_ASSOC 16
+
+typedef struct Cache_Struct {
+	int enabled;
+	const char *name;
+
+	// geometry
+	uint32_t size;
+	uint32_t assoc;
+	uint32_t line;
+	uint32_t sets;
+	int line_bits;
+	int set_bits;
+	int policy;
+
+	// tags, sets * assoc entries, each (tag << 1) | valid
+	uint32_t *tags;
+
+	// replacement state, one word per set: 4-bit LRU ranks or PLRU tree bits
+	uint64_t *repl;
+	uint32_t random;
+
+	uint64_t hits;
+	uint64_t misses;
+
+	// accesses and misses by PC, indexed by (PC - MEM_TEXT_START) >> 2
+	uint32_t *pc_accesses;
+	uint32_t *pc_misses;
+} Cache;
+
+extern Cache ICACHE;
+extern Cache DCACHE;
+
+/*
+ * cache_configure
+ * Configure and enable a cache from a spec "i|d:size:assoc:line:policy",
+ * e.g. "d:32k:4:32:lru". Policy is one of lru, plru or random.
+ * Returns 0 on success, -1 on a malformed or unsupported spec.
+ */
+int cache_configure(const char *spec);
+
+/*
+ * cache_access
+ * Look up address, filling the line on a miss. Returns 1 on a hit.
+ */
+int cache_access(Cache *cache, uint32_t address, uint32_t pc);
+
+/*
+ * cache_report
+ * Print hits, misses and miss rate, overall and for the top_n PCs by misses.
+ */
+void cache_report(Cache *cache, FILE *out, int top_n);
+
+#endif // __CACHE_H
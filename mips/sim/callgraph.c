@@ -0,0 +1,267 @@
+/*
+ * callgraph.c
+ * Call-graph profiler driven by a shadow call stack.
+ *
+ * Calls (jal, jalr and taken bltzal/bgezal) push a frame for the callee;
+ * jr $ra pops back to the frame whose return address it lands on, which
+ * also copes with returns that skip frames. Every retired instruction is
+ * charged to the top frame, both in a flat per-function table and in a
+ * calling context tree used for folded stack export.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shell.h"
+#include "retire.h"
+#include "callgraph.h"
+
+int CALLGRAPH_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define CALLGRAPH_SLOTS (MEM_TEXT_SIZE >> 2)
+
+// one more slot gathers functions outside the text segment (kernel text)
+#define OTHER_SLOT  CALLGRAPH_SLOTS
+#define TOTAL_SLOTS (CALLGRAPH_SLOTS + 1)
+
+// calling context tree node, node 0 is the root
+typedef struct {
+	uint32_t entry;
+	uint32_t parent;
+	uint32_t child;     // first child, 0 when none
+	uint32_t sibling;   // next child of the parent, 0 when none
+	uint64_t self;      // instructions executed in this context
+} Node;
+
+typedef struct {
+	uint32_t node;
+	uint32_t return_addr;
+	uint64_t start;     // instructions retired when the frame was pushed
+} Frame;
+
+static Node *nodes;
+static uint32_t node_count, node_capacity;
+
+static Frame *stack;
+static uint32_t depth, stack_capacity, max_depth;
+
+static uint64_t retired;
+
+// per function, indexed by (entry - MEM_TEXT_START) >> 2, or OTHER_SLOT
+static uint64_t *inclusive;
+static uint64_t *exclusive;
+static uint32_t *calls;
+static uint32_t *active;    // frames of the function currently on the stack
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static uint32_t slot_of(uint32_t entry) {
+	uint32_t slot = (entry - MEM_TEXT_START) >> 2;
+	return slot < CALLGRAPH_SLOTS ? slot : OTHER_SLOT;
+}
+
+static uint32_t new_node(uint32_t entry, uint32_t parent) {
+	if (node_count == node_capacity) {
+		node_capacity = node_capacity ? node_capacity * 2 : 1024;
+		nodes = realloc(nodes, node_capacity * sizeof(Node));
+	}
+
+	Node *node = &nodes[node_count];
+	memset(node, 0, sizeof(Node));
+	node->entry = entry;
+	node->parent = parent;
+	return node_count++;
+}
+
+static void push(uint32_t entry, uint32_t return_addr) {
+	uint32_t node = 0;
+
+	// find or add the callee under the caller's context (the root has none)
+	if (depth) {
+		uint32_t parent = stack[depth - 1].node;
+
+		for (node = nodes[parent].child; node; node = nodes[node].sibling) {
+			if (nodes[node].entry == entry) {
+				break;
+			}
+		}
+		if (!node) {
+			node = new_node(entry, parent);
+			nodes[node].sibling = nodes[parent].child;
+			nodes[parent].child = node;
+		}
+	}
+
+	if (depth == stack_capacity) {
+		stack_capacity = stack_capacity ? stack_capacity * 2 : 256;
+		stack = realloc(stack, stack_capacity * sizeof(Frame));
+	}
+
+	stack[depth].node = node;
+	stack[depth].return_addr = return_addr;
+	stack[depth].start = retired;
+	depth++;
+	if (depth > max_depth) {
+		max_depth = depth;
+	}
+
+	calls[slot_of(entry)]++;
+	active[slot_of(entry)]++;
+}
+
+static void pop(void) {
+	Frame *frame = &stack[--depth];
+	uint32_t slot = slot_of(nodes[frame->node].entry);
+
+	// recursive calls are counted once, by the outermost frame
+	if (--active[slot] == 0) {
+		inclusive[slot] += retired - frame->start;
+	}
+}
+
+// sort slots by descending inclusive count
+static const uint64_t *sort_counts;
+
+static int compare_slots(const void *a, const void *b) {
+	uint64_t ca = sort_counts[*(const uint32_t *) a];
+	uint64_t cb = sort_counts[*(const uint32_t *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Call Graph Interface
+	See module header file (callgraph.h) for detailed function comments.
+*/
+
+void callgraph_enable(void) {
+	if (CALLGRAPH_ENABLED) {
+		return;
+	}
+
+	inclusive = calloc(TOTAL_SLOTS, sizeof(uint64_t));
+	exclusive = calloc(TOTAL_SLOTS, sizeof(uint64_t));
+	calls     = calloc(TOTAL_SLOTS, sizeof(uint32_t));
+	active    = calloc(TOTAL_SLOTS, sizeof(uint32_t));
+	CALLGRAPH_ENABLED = 1;
+}
+
+void callgraph_retire(uint32_t pc, uint32_t next_pc, uint32_t flags) {
+	// the first instruction executed is the root function
+	if (depth == 0) {
+		new_node(pc, 0);
+		push(pc, 0);
+	}
+
+	Frame *top = &stack[depth - 1];
+	nodes[top->node].self++;
+	exclusive[slot_of(nodes[top->node].entry)]++;
+	retired++;
+
+	if (flags & RECORD_CALL) {
+		push(next_pc, pc + 4);
+	} else if ((flags & RECORD_RETURN) && depth > 1) {
+		// unwind to the frame returning to next_pc, or one frame if none does
+		uint32_t target = depth - 1;
+		for (uint32_t i = depth - 1; i > 0; i--) {
+			if (stack[i].return_addr == next_pc) {
+				target = i;
+				break;
+			}
+		}
+		while (depth > target) {
+			pop();
+		}
+	}
+}
+
+void callgraph_report(FILE *out, int top_n) {
+	uint32_t n = 0;
+
+	if (!CALLGRAPH_ENABLED || depth == 0) {
+		return;
+	}
+
+	// frames still live at halt count towards the inclusive totals
+	uint64_t *totals = malloc(TOTAL_SLOTS * sizeof(uint64_t));
+	memcpy(totals, inclusive, TOTAL_SLOTS * sizeof(uint64_t));
+	uint8_t *seen = calloc(TOTAL_SLOTS, 1);
+	for (uint32_t i = 0; i < depth; i++) {
+		uint32_t slot = slot_of(nodes[stack[i].node].entry);
+		if (!seen[slot]) {
+			seen[slot] = 1;
+			totals[slot] += retired - stack[i].start;
+		}
+	}
+	free(seen);
+
+	uint32_t *slots = malloc(TOTAL_SLOTS * sizeof(uint32_t));
+	for (uint32_t slot = 0; slot < TOTAL_SLOTS; slot++) {
+		if (calls[slot]) {
+			slots[n++] = slot;
+		}
+	}
+	sort_counts = totals;
+	qsort(slots, n, sizeof(uint32_t), compare_slots);
+
+	fprintf(out, "\nCall graph profile (%u functions, %u contexts, max depth %u) :\n",
+		n, node_count, max_depth);
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  %-10s  %10s  %14s  %7s  %14s  %7s\n", "function", "calls",
+		"inclusive", "", "exclusive", "");
+	for (uint32_t i = 0; i < n && i < (uint32_t) top_n; i++) {
+		uint32_t slot = slots[i];
+		if (slot == OTHER_SLOT) {
+			fprintf(out, "  %-10s", "(other)");
+		} else {
+			fprintf(out, "  0x%08x", MEM_TEXT_START + (slot << 2));
+		}
+		fprintf(out, "  %10u  %14llu  %6.2f%%  %14llu  %6.2f%%\n", calls[slot],
+			(unsigned long long) totals[slot], 100.0 * totals[slot] / retired,
+			(unsigned long long) exclusive[slot], 100.0 * exclusive[slot] / retired);
+	}
+	fprintf(out, "\n");
+
+	free(slots);
+	free(totals);
+}
+
+int callgraph_folded(const char *filename) {
+	FILE *out;
+
+	if (!CALLGRAPH_ENABLED || (out = fopen(filename, "w")) == NULL) {
+		return -1;
+	}
+
+	uint32_t *path = malloc((max_depth + 1) * sizeof(uint32_t));
+	for (uint32_t node = 0; node < node_count; node++) {
+		uint32_t length = 0;
+
+		if (nodes[node].self == 0) {
+			continue;
+		}
+
+		// collect the context leaf to root, print it root to leaf
+		for (uint32_t n = node; ; n = nodes[n].parent) {
+			path[length++] = nodes[n].entry;
+			if (n == 0) {
+				break;
+			}
+		}
+		while (length--) {
+			fprintf(out, "0x%08x%s", path[length], length ? ";" : "");
+		}
+		fprintf(out, " %llu\n", (unsigned long long) nodes[node].self);
+	}
+	free(path);
+
+	fclose(out);
+	return 0;
+}
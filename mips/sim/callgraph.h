@@ -0,0 +1,44 @@
+/*
+ * callgraph.h
+ * Call-graph profiler driven by a shadow call stack.
+ */
+
+#ifndef __CALLGRAPH_H
+#define __CALLGRAPH_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// whether the call-graph profiler is on
+extern int CALLGRAPH_ENABLED;
+
+/*
+ * callgraph_enable
+ * Allocate the per-function counters and call tree, turning the profiler on.
+ */
+void callgraph_enable(void);
+
+/*
+ * callgraph_retire
+ * Charge one instruction at pc to the function on top of the shadow stack,
+ * then push a frame for a call (RECORD_CALL in flags) or pop one for a
+ * return (RECORD_RETURN) that lands on next_pc.
+ */
+void callgraph_retire(uint32_t pc, uint32_t next_pc, uint32_t flags);
+
+/*
+ * callgraph_report
+ * Print calls and inclusive/exclusive instruction counts for the top_n
+ * functions by inclusive count. Functions are named by entry address;
+ * those outside the text segment are counted together as (other).
+ */
+void callgraph_report(FILE *out, int top_n);
+
+/*
+ * callgraph_folded
+ * Write exclusive counts per call stack in folded format ("a;b;c count"),
+ * the input of flame graph tools. Returns 0 on success.
+ */
+int callgraph_folded(const char *filename);
+
+#endif // __CALLGRAPH_H
@@ -0,0 +1,125 @@
+/*
+ * cost.c
+ * Host time spent in each instruction handler and in guest memory access.
+ *
+ * process_instruction reads the timestamp counter around each dispatch and
+ * mem_read_32/mem_write_32 around each access, so memory time is nested in
+ * the handler (and fetch) times. The average cost of reading the counter
+ * is measured once and subtracted from every call. Ticks are converted to
+ * nanoseconds against the monotonic clock over the whole run.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sample.h"
+#include "cost.h"
+
+int COST_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+static uint64_t calls[COST_SLOTS];
+static uint64_t ticks[COST_SLOTS];
+
+// average ticks of back-to-back timestamp reads
+static double overhead;
+
+// run start, for converting ticks to nanoseconds
+static uint64_t start_ticks;
+static double start_ns;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static double monotonic_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static const char *slot_name(int slot) {
+	if (slot == COST_MEM_READ) {
+		return "mem_read_32";
+	} else if (slot == COST_MEM_WRITE) {
+		return "mem_write_32";
+	}
+	return handler_name(slot);
+}
+
+// net ticks of a slot, less the timer overhead
+static double net_ticks(int slot) {
+	double net = ticks[slot] - overhead * calls[slot];
+	return net > 0 ? net : 0;
+}
+
+static int compare_slots(const void *a, const void *b) {
+	double ca = net_ticks(*(const int *) a);
+	double cb = net_ticks(*(const int *) b);
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Cost Interface
+	See module header file (cost.h) for detailed function comments.
+*/
+
+void cost_enable(void) {
+	uint64_t total = 0;
+
+	for (int i = 0; i < 1000; i++) {
+		uint64_t t0 = cost_now();
+		total += cost_now() - t0;
+	}
+	overhead = total / 1000.0;
+
+	start_ns = monotonic_ns();
+	start_ticks = cost_now();
+	COST_ENABLED = 1;
+}
+
+void cost_add(int slot, uint64_t delta) {
+	calls[slot]++;
+	ticks[slot] += delta;
+}
+
+void cost_report(FILE *out) {
+	int order[COST_SLOTS], n = 0;
+	double handler_ticks = 0;
+
+	if (!COST_ENABLED) {
+		return;
+	}
+
+	double ns_per_tick = (monotonic_ns() - start_ns) / (double) (cost_now() - start_ticks);
+
+	for (int slot = 0; slot < COST_SLOTS; slot++) {
+		if (calls[slot]) {
+			order[n++] = slot;
+			if (slot < HANDLER_SLOTS) {
+				handler_ticks += net_ticks(slot);
+			}
+		}
+	}
+	qsort(order, n, sizeof(int), compare_slots);
+
+	fprintf(out, "\nHost cost per handler (%.3f ns per tick, %.1f ticks timer overhead removed) :\n",
+		ns_per_tick, overhead);
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  %-20s  %12s  %10s  %12s  %7s\n", "handler", "calls", "ns/call",
+		"total ms", "share");
+	for (int i = 0; i < n; i++) {
+		int slot = order[i];
+		double ns = net_ticks(slot) * ns_per_tick;
+		fprintf(out, "  %-20s  %12llu  %10.2f  %12.3f  %6.2f%%%s\n", slot_name(slot),
+			(unsigned long long) calls[slot], ns / calls[slot], ns / 1e6,
+			handler_ticks ? 100.0 * net_ticks(slot) / handler_ticks : 0.0,
+			slot >= HANDLER_SLOTS ? "  (nested)" : "");
+	}
+	fprintf(out, "\n");
+}
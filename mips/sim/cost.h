@@ -0,0 +1,60 @@
+/*
+ * cost.h
+ * Host time spent in each instruction handler and in guest memory access.
+ */
+
+#ifndef __COST_H
+#define __COST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "sample.h"
+
+// cost slots: one per handler identifier, then the memory accessors
+#define COST_MEM_READ  HANDLER_SLOTS
+#define COST_MEM_WRITE (HANDLER_SLOTS + 1)
+#define COST_SLOTS     (HANDLER_SLOTS + 2)
+
+// whether handler costs are being measured
+extern int COST_ENABLED;
+
+/*
+ * cost_now
+ * Host timestamp: the time stamp counter on x86, nanoseconds elsewhere.
+ */
+static inline uint64_t cost_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+/*
+ * cost_enable
+ * Measure the timer overhead and start measuring.
+ */
+void cost_enable(void);
+
+/*
+ * cost_add
+ * Charge one call taking ticks timestamp units to a cost slot.
+ */
+void cost_add(int slot, uint64_t ticks);
+
+/*
+ * cost_report
+ * Print calls, ns per call and share of handler time for every slot used,
+ * most expensive first.
+ */
+void cost_report(FILE *out);
+
+#endif // __COST_H
@@ -0,0 +1,71 @@
+/*
+ * counters.c
+ * Performance counters readable by guest programs.
+ *
+ * Counters are computed from the simulator's own statistics when the guest
+ * reads them, so keeping them costs nothing while the guest isn't looking.
+ * Cache and timing statistics come from the analysis consumers, which are
+ * drained first when they run on their own threads.
+ */
+
+#include <stdint.h>
+
+#include "sim.h"
+#include "shell.h"
+#include "stats.h"
+#include "cache.h"
+#include "timing.h"
+#include "retire.h"
+#include "cp0.h"
+#include "counters.h"
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+// counter latched by the last low word read
+static uint64_t latched;
+
+/*
+ * counter_value
+ * Current value of the counter at offset.
+ */
+static uint64_t counter_value(uint32_t offset) {
+	switch (offset) {
+	case COUNTER_INSTRUCTIONS:   return stats_instructions();
+	case COUNTER_CYCLES:         return TIMING.enabled ? TIMING.cycles : 0;
+	case COUNTER_LOADS:          return stats_loads();
+	case COUNTER_STORES:         return stats_stores();
+	case COUNTER_BRANCHES:       return STATS.branch_taken + STATS.branch_not_taken;
+	case COUNTER_BRANCHES_TAKEN: return STATS.branch_taken;
+	case COUNTER_ICACHE_ACCESS:  return ICACHE.hits + ICACHE.misses;
+	case COUNTER_ICACHE_MISS:    return ICACHE.misses;
+	case COUNTER_DCACHE_ACCESS:  return DCACHE.hits + DCACHE.misses;
+	case COUNTER_DCACHE_MISS:    return DCACHE.misses;
+	case COUNTER_EXCEPTIONS:     return cp0_exceptions();
+	default:                     return 0;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Counter Interface
+	See module header file (counters.h) for detailed function comments.
+*/
+
+uint32_t counters_read(void *unused, uint32_t offset) {
+	if (offset & 4) {
+		return (uint32_t) (latched >> 32);
+	}
+
+	retire_drain();
+	latched = counter_value(offset & ~7);
+	return (uint32_t) latched;
+}
+
+uint64_t counter_cycles(void) {
+	if (TIMING.enabled) {
+		retire_drain();
+		return TIMING.cycles;
+	}
+	return INSTRUCTION_COUNT;
+}
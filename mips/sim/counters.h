@@ -0,0 +1,45 @@
+/*
+ * counters.h
+ * Performance counters readable by guest programs.
+ *
+ * A read-only device of 64-bit counters at COUNTERS_BASE, each stored low
+ * word first. Reading a low word latches the counter, so the high word
+ * read next belongs to the same value.
+ */
+
+#ifndef __COUNTERS_H
+#define __COUNTERS_H
+
+#include <stdint.h>
+
+#define COUNTERS_BASE 0xBFFF0000
+#define COUNTERS_SIZE 0x00000100
+
+// counter offsets from COUNTERS_BASE
+#define COUNTER_INSTRUCTIONS   0x00  // retired instructions
+#define COUNTER_CYCLES         0x08  // timing model cycles, 0 without -T
+#define COUNTER_LOADS          0x10  // loads of any width, including FP
+#define COUNTER_STORES         0x18  // stores of any width, including FP
+#define COUNTER_BRANCHES       0x20  // conditional branches
+#define COUNTER_BRANCHES_TAKEN 0x28  // conditional branches taken
+#define COUNTER_ICACHE_ACCESS  0x30  // instruction cache accesses, 0 without -c i:...
+#define COUNTER_ICACHE_MISS    0x38  // instruction cache misses
+#define COUNTER_DCACHE_ACCESS  0x40  // data cache accesses, 0 without -c d:...
+#define COUNTER_DCACHE_MISS    0x48  // data cache misses
+#define COUNTER_EXCEPTIONS     0x50  // exceptions taken
+
+/*
+ * counters_read
+ * MMIO read of the counter word at offset. Unassigned words read as 0.
+ */
+uint32_t counters_read(void *unused, uint32_t offset);
+
+/*
+ * counter_cycles
+ * The cycle counter seen by the guest through CP0 Count and rdhwr $2:
+ * timing model cycles when the pipeline model is on, otherwise retired
+ * instructions.
+ */
+uint64_t counter_cycles(void);
+
+#endif // __COUNTERS_H
@@ -0,0 +1,306 @@
+/*
+ * cp0.c
+ * Coprocessor 0: exception state and delivery.
+ *
+ * Exceptions are detected where they happen (overflow checks in the add
+ * handlers, alignment checks in the loads and stores, the unrecognized
+ * handlers), so the instructions that can't fault pay nothing. There are
+ * no delay slots in this simulator, so EPC is always the faulting
+ * instruction and Cause.BD is never set.
+ *
+ * Interrupts are events: whatever changes the request lines, Status or
+ * Cause schedules an immediate event when an interrupt becomes deliverable,
+ * so the run loop checks for them with the same compare as other events.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "shell.h"
+#include "decode.h"
+#include "counters.h"
+#include "events.h"
+#include "tlb.h"
+#include "cp0.h"
+
+CP0_State CP0;
+
+uint32_t EXCEPTION_VECTOR = EXCEPTION_VECTOR_DEFAULT;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+// exceptions taken, by code
+static uint64_t taken[EXC_CODES];
+
+// Count is the guest cycle counter plus this, so writing Count moves it
+static uint32_t count_offset;
+
+static void take_interrupt(void *unused);
+static void timer_expire(void *unused);
+
+// interrupts are taken between instructions, from the event loop
+static TimedEvent interrupt_event = { .handler = take_interrupt };
+
+// fires when Count reaches Compare, armed by the first write to Compare
+static TimedEvent timer_event = { .handler = timer_expire };
+static int timer_armed;
+
+static const char *EXCEPTION_NAMES[EXC_CODES] = {
+	[EXC_INT]  = "interrupt",
+	[EXC_MOD]  = "TLB modified",
+	[EXC_TLBL] = "TLB (load/fetch)",
+	[EXC_TLBS] = "TLB (store)",
+	[EXC_ADEL] = "address error (load/fetch)",
+	[EXC_ADES] = "address error (store)",
+	[EXC_RI]   = "reserved instruction",
+	[EXC_CPU]  = "coprocessor unusable",
+	[EXC_OV]   = "overflow",
+};
+
+// bits mtc0 leaves alone; other registers are written whole
+static const uint32_t READ_ONLY[CP0_REGS] = {
+	[CP0_INDEX]    = ~(uint32_t) (TLB_ENTRIES - 1),
+	[CP0_RANDOM]   = 0xFFFFFFFF,
+	[CP0_ENTRYLO0] = ~(ENTRYLO_PFN | 0x3F),
+	[CP0_ENTRYLO1] = ~(ENTRYLO_PFN | 0x3F),
+	[CP0_CONTEXT]  = ~CONTEXT_PTEBASE,
+	[CP0_PAGEMASK] = ~PAGEMASK_MASK,
+	[CP0_WIRED]    = ~(uint32_t) (TLB_ENTRIES - 1),
+	[CP0_BADVADDR] = 0xFFFFFFFF,
+	[CP0_ENTRYHI]  = ~(ENTRYHI_VPN2 | ENTRYHI_ASID),
+};
+
+/* ----------------------------------------------------------------------------
+	Interrupts and Timer
+*/
+
+static int interrupt_deliverable(void) {
+	uint32_t status = CP0.REGS[CP0_STATUS];
+
+	return (status & STATUS_IE) && !(status & STATUS_EXL) &&
+		(CP0.REGS[CP0_CAUSE] & status & STATUS_IM);
+}
+
+/*
+ * check_interrupts
+ * Arrange to take an interrupt before the next instruction if one is
+ * deliverable. Called whenever Status, Cause or the request lines change.
+ */
+static void check_interrupts(void) {
+	if (interrupt_deliverable()) {
+		event_schedule(&interrupt_event, 0);
+	}
+}
+
+static void take_interrupt(void *unused) {
+	if (!interrupt_deliverable()) {
+		return;
+	}
+
+	// between instructions, EPC is the next instruction to run
+	exception_raise(EXC_INT, 0);
+	CURRENT_STATE.PC = NEXT_STATE.PC;
+}
+
+static void timer_arm(void) {
+	event_schedule(&timer_event, (uint32_t) (CP0.REGS[CP0_COMPARE] - cp0_count()));
+	timer_armed = 1;
+}
+
+static void timer_expire(void *unused) {
+	int32_t remaining = (int32_t) (CP0.REGS[CP0_COMPARE] - cp0_count());
+
+	// Count follows cycles under the pipeline model, and may not be there yet
+	if (remaining > 0) {
+		event_schedule(&timer_event, remaining);
+		return;
+	}
+
+	CP0.REGS[CP0_CAUSE] |= CAUSE_TI;
+	cp0_raise_interrupt(CAUSE_IP_TIMER);
+}
+
+/* ----------------------------------------------------------------------------
+	Exception Delivery
+*/
+
+static int tlb_exception(int code) {
+	return code == EXC_MOD || code == EXC_TLBL || code == EXC_TLBS;
+}
+
+/*
+ * deliver
+ * Take an exception at vector, or halt if no handler is loaded there.
+ */
+static int deliver(int code, uint32_t address, uint32_t vector) {
+	taken[code]++;
+
+	// with no handler to run, stop where the program faulted
+	if (mem_read_32(vector) == 0) {
+		fprintf(stderr, "ERROR: unhandled %s exception at 0x%08x\n",
+			EXCEPTION_NAMES[code] ? EXCEPTION_NAMES[code] : "unknown", CURRENT_STATE.PC);
+		NEXT_STATE.PC = CURRENT_STATE.PC;
+		RUN_BIT = 0;
+		return STATUS_ERR;
+	}
+
+	// an exception inside a handler keeps the original return address
+	if (!(CP0.REGS[CP0_STATUS] & STATUS_EXL)) {
+		CP0.REGS[CP0_EPC] = CURRENT_STATE.PC;
+	}
+	if (code == EXC_ADEL || code == EXC_ADES || tlb_exception(code)) {
+		CP0.REGS[CP0_BADVADDR] = address;
+	}
+	// the handler finds the page table entry through Context, and EntryHi is set up to write it
+	if (tlb_exception(code)) {
+		CP0.REGS[CP0_CONTEXT] = (CP0.REGS[CP0_CONTEXT] & CONTEXT_PTEBASE) | ((address >> 9) & CONTEXT_BADVPN2);
+		CP0.REGS[CP0_ENTRYHI] = (address & ENTRYHI_VPN2) | (CP0.REGS[CP0_ENTRYHI] & ENTRYHI_ASID);
+	}
+	CP0.REGS[CP0_CAUSE] = (CP0.REGS[CP0_CAUSE] & ~CAUSE_EXCCODE) | (code << CAUSE_SHIFT_EXCCODE);
+	CP0.REGS[CP0_STATUS] |= STATUS_EXL;
+
+	NEXT_STATE.PC = vector;
+	return STATUS_ERR;
+}
+
+/* ----------------------------------------------------------------------------
+	Coprocessor 0 Interface
+	See module header file (cp0.h) for detailed function comments.
+*/
+
+int exception_raise(int code, uint32_t address) {
+	return deliver(code, address, EXCEPTION_VECTOR);
+}
+
+int exception_raise_refill(int code, uint32_t address) {
+	uint32_t refill = EXCEPTION_VECTOR - REFILL_VECTOR_OFFSET;
+
+	// a refill inside a handler is an ordinary exception
+	if (!(CP0.REGS[CP0_STATUS] & STATUS_EXL) && refill >= MEM_KTEXT_START && mem_read_32(refill) != 0) {
+		return deliver(code, address, refill);
+	}
+	return deliver(code, address, EXCEPTION_VECTOR);
+}
+
+int handle_cop0(uint32_t instr) {
+	int rt = decode_r_rt(instr);
+	int rd = decode_r_rd(instr);
+	uint32_t status = CP0.REGS[CP0_STATUS];
+
+	// user mode may only use coprocessor 0 if the kernel grants it
+	if ((status & (STATUS_UM | STATUS_EXL | STATUS_ERL)) == STATUS_UM && !(status & STATUS_CU0)) {
+		CP0.REGS[CP0_CAUSE] &= ~CAUSE_CE;
+		return exception_raise(EXC_CPU, 0);
+	}
+
+	switch (decode_r_rs(instr)) {
+	case COP0_MF:
+		if (rd == CP0_COUNT) {
+			NEXT_STATE.REGS[rt] = cp0_count();
+		} else if (rd == CP0_RANDOM) {
+			NEXT_STATE.REGS[rt] = tlb_random();
+		} else {
+			NEXT_STATE.REGS[rt] = CP0.REGS[rd];
+		}
+		break;
+	case COP0_MT:
+		if (rd == CP0_COUNT) {
+			count_offset = CURRENT_STATE.REGS[rt] - (uint32_t) counter_cycles();
+			if (timer_armed) {
+				timer_arm();
+			}
+		} else if (rd == CP0_COMPARE) {
+			// writing Compare acknowledges the timer interrupt and restarts the timer
+			CP0.REGS[rd] = CURRENT_STATE.REGS[rt];
+			CP0.REGS[CP0_CAUSE] &= ~CAUSE_TI;
+			cp0_clear_interrupt(CAUSE_IP_TIMER);
+			timer_arm();
+		} else if (rd == CP0_CAUSE) {
+			// only the software interrupt bits are writable
+			CP0.REGS[rd] = (CP0.REGS[rd] & ~CAUSE_IP_SW) | (CURRENT_STATE.REGS[rt] & CAUSE_IP_SW);
+			check_interrupts();
+		} else {
+			uint32_t asid = CP0.REGS[CP0_ENTRYHI] & ENTRYHI_ASID;
+
+			CP0.REGS[rd] = (CP0.REGS[rd] & READ_ONLY[rd]) | (CURRENT_STATE.REGS[rt] & ~READ_ONLY[rd]);
+			if (rd == CP0_STATUS) {
+				check_interrupts();
+			} else if (rd == CP0_ENTRYHI && (CP0.REGS[rd] & ENTRYHI_ASID) != asid) {
+				// recent translations belong to the old address space
+				tlb_flush();
+			}
+		}
+		break;
+	case COP0_CO:
+		switch (decode_r_funct(instr)) {
+		case FUNC_CO_ERET:
+			// return from the handler, and take anything that arrived meanwhile
+			CP0.REGS[CP0_STATUS] &= ~STATUS_EXL;
+			NEXT_STATE.PC = CP0.REGS[CP0_EPC];
+			check_interrupts();
+			return STATUS_OK;
+		case FUNC_CO_TLBR:
+		case FUNC_CO_TLBWI:
+		case FUNC_CO_TLBWR:
+		case FUNC_CO_TLBP:
+			// there is no TLB unless it is enabled
+			if (!TLB_ENABLED) {
+				return exception_raise(EXC_RI, 0);
+			}
+			tlb_operation(decode_r_funct(instr));
+			break;
+		default:
+			return exception_raise(EXC_RI, 0);
+		}
+		break;
+	default:
+		return exception_raise(EXC_RI, 0);
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+void cp0_raise_interrupt(uint32_t lines) {
+	CP0.REGS[CP0_CAUSE] |= lines & CAUSE_IP;
+	check_interrupts();
+}
+
+void cp0_clear_interrupt(uint32_t lines) {
+	CP0.REGS[CP0_CAUSE] &= ~(lines & CAUSE_IP);
+}
+
+uint32_t cp0_count(void) {
+	return (uint32_t) counter_cycles() + count_offset;
+}
+
+uint64_t cp0_exceptions(void) {
+	uint64_t total = 0;
+
+	for (int code = 0; code < EXC_CODES; code++) {
+		total += taken[code];
+	}
+	return total;
+}
+
+void cp0_report(FILE *out) {
+	if (!cp0_exceptions()) {
+		return;
+	}
+
+	fprintf(out, "\nExceptions :\n");
+	fprintf(out, "-------------------------------------\n");
+	for (int code = 0; code < EXC_CODES; code++) {
+		if (taken[code]) {
+			fprintf(out, "  %-28s : %12llu\n", EXCEPTION_NAMES[code] ? EXCEPTION_NAMES[code] : "unknown",
+				(unsigned long long) taken[code]);
+		}
+	}
+	fprintf(out, "\n");
+}
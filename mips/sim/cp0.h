@@ -0,0 +1,148 @@
+/*
+ * cp0.h
+ * Coprocessor 0: exception state and delivery.
+ */
+
+#ifndef __CP0_H
+#define __CP0_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "shell.h"
+
+#define CP0_REGS 32
+
+// register numbers, as named by mfc0 and mtc0
+#define CP0_INDEX     0   // TLB registers, see tlb.h
+#define CP0_RANDOM    1
+#define CP0_ENTRYLO0  2
+#define CP0_ENTRYLO1  3
+#define CP0_CONTEXT   4
+#define CP0_PAGEMASK  5
+#define CP0_WIRED     6
+#define CP0_BADVADDR  8
+#define CP0_COUNT     9   // cycle counter, see counter_cycles (counters.h)
+#define CP0_ENTRYHI  10
+#define CP0_COMPARE  11
+#define CP0_STATUS   12
+#define CP0_CAUSE    13
+#define CP0_EPC      14
+
+// Status fields
+#define STATUS_IE   0x00000001  // interrupt enable
+#define STATUS_EXL  0x00000002  // exception level, set while a handler runs
+#define STATUS_ERL  0x00000004  // error level
+#define STATUS_UM   0x00000010  // user mode, unless EXL or ERL is set
+#define STATUS_IM   0x0000FF00  // interrupt mask
+#define STATUS_CU0  0x10000000  // coprocessor 0 usable in user mode
+
+// Cause fields
+#define CAUSE_EXCCODE        0x0000007C
+#define CAUSE_SHIFT_EXCCODE  2
+#define CAUSE_IP             0x0000FF00  // pending interrupts
+#define CAUSE_IP_SW          0x00000300  // software interrupts, writable by mtc0
+#define CAUSE_IP_HW(n)       (0x00000400 << (n))  // hardware interrupt n, 0-5
+#define CAUSE_IP_TIMER       CAUSE_IP_HW(5)       // timer interrupt, IP7
+#define CAUSE_CE             0x30000000  // coprocessor of a coprocessor unusable exception
+#define CAUSE_TI             0x40000000  // timer interrupt pending
+
+// TLB register fields
+#define INDEX_P            0x80000000  // tlbp found no match
+#define ENTRYLO_PFN        0x3FFFFFC0  // physical frame number
+#define ENTRYLO_SHIFT_PFN  6
+#define ENTRYLO_D          0x00000004  // dirty: writable
+#define ENTRYLO_V          0x00000002  // valid
+#define ENTRYLO_G          0x00000001  // global: ignore the ASID
+#define CONTEXT_PTEBASE    0xFF800000
+#define CONTEXT_BADVPN2    0x007FFFF0
+#define PAGEMASK_MASK      0x1FFFE000
+#define ENTRYHI_VPN2       0xFFFFE000  // virtual page pair number
+#define ENTRYHI_ASID       0x000000FF  // address space identifier
+
+// exception codes, in Cause.ExcCode
+#define EXC_INT    0   // interrupt
+#define EXC_MOD    1   // store to a page that isn't dirty
+#define EXC_TLBL   2   // TLB refill or invalid entry on a load or instruction fetch
+#define EXC_TLBS   3   // TLB refill or invalid entry on a store
+#define EXC_ADEL   4   // address error on a load or instruction fetch
+#define EXC_ADES   5   // address error on a store
+#define EXC_RI    10   // reserved instruction
+#define EXC_CPU   11   // coprocessor unusable
+#define EXC_OV    12   // arithmetic overflow
+#define EXC_CODES 32
+
+// general exception vector, unless moved with -K
+#define EXCEPTION_VECTOR_DEFAULT (MEM_KTEXT_START + 0x180)
+
+// the TLB refill vector is this far below the general vector
+#define REFILL_VECTOR_OFFSET 0x180
+
+typedef struct CP0_State_Struct {
+	uint32_t REGS[CP0_REGS];
+} CP0_State;
+
+// coprocessor 0 registers; like the FPU, not double-buffered
+extern CP0_State CP0;
+
+// address the processor jumps to on an exception
+extern uint32_t EXCEPTION_VECTOR;
+
+/*
+ * exception_raise
+ * Deliver an exception for the instruction at CURRENT_STATE.PC: record it
+ * in EPC and Cause (and address in BadVAddr for address and TLB errors,
+ * and in Context and EntryHi for TLB errors), set
+ * Status.EXL and continue at EXCEPTION_VECTOR. Handlers call this before
+ * writing any result, so the faulting instruction has no other effect. If
+ * no handler is loaded at the vector, report the exception and halt.
+ * Returns STATUS_ERR, for handlers to return.
+ */
+int exception_raise(int code, uint32_t address);
+
+/*
+ * exception_raise_refill
+ * Deliver a TLB refill exception, EXC_TLBL or EXC_TLBS. Outside a handler
+ * it goes to the refill vector if a handler is loaded there, otherwise to
+ * EXCEPTION_VECTOR like any other exception.
+ */
+int exception_raise_refill(int code, uint32_t address);
+
+/*
+ * cp0_raise_interrupt, cp0_clear_interrupt
+ * Assert or deassert interrupt request lines (CAUSE_IP_HW bits). An
+ * asserted line that is unmasked in Status is taken before the next
+ * instruction once interrupts are enabled and no handler is running.
+ */
+void cp0_raise_interrupt(uint32_t lines);
+void cp0_clear_interrupt(uint32_t lines);
+
+/*
+ * handle_cop0
+ * Coprocessor 0 operations: mfc0, mtc0, eret and, with the TLB enabled,
+ * tlbr, tlbwi, tlbwr and tlbp. Writing Compare starts the timer, which
+ * raises IP7 when Count reaches it. In user mode they raise coprocessor
+ * unusable unless Status.CU0 is set.
+ * Opcode: 16
+ */
+int handle_cop0(uint32_t instr);
+
+/*
+ * cp0_count
+ * Current value of the Count register.
+ */
+uint32_t cp0_count(void);
+
+/*
+ * cp0_exceptions
+ * Total number of exceptions taken.
+ */
+uint64_t cp0_exceptions(void);
+
+/*
+ * cp0_report
+ * Print the number of exceptions taken of each kind, if any.
+ */
+void cp0_report(FILE *out);
+
+#endif // __CP0_H
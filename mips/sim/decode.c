@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "sim.h"
 #include "mips.h"
 
 /* ----------------------------------------------------------------------------
@@ -73,3 +74,82 @@ int decode_r_shamt(uint32_t instr) {
 int decode_r_funct(uint32_t instr) {
 	return (int) ((instr & MASK_R_FUNCT) >> SHIFT_R_FUNCT); 
 }
+
+/* ----------------------------------------------------------------------------
+	Instruction Mnemonics 
+	See module header file (decode.h) for detailed comments. 
+*/
+
+const char *OPCODE_NAMES[DISPATCH_SIZE] = {
+	[OPCODE_SPECIAL] = "special",
+	[OPCODE_REGIMM]  = "regimm",
+	[OPCODE_J]       = "j",
+	[OPCODE_JAL]     = "jal",
+	[OPCODE_BEQ]     = "beq",
+	[OPCODE_BNE]     = "bne",
+	[OPCODE_BLEZ]    = "blez",
+	[OPCODE_BGTZ]    = "bgtz",
+	[OPCODE_ADDI]    = "addi",
+	[OPCODE_ADDIU]   = "addiu",
+	[OPCODE_SLTI]    = "slti",
+	[OPCODE_SLTIU]   = "sltiu",
+	[OPCODE_ANDI]    = "andi",
+	[OPCODE_ORI]     = "ori",
+	[OPCODE_XORI]    = "xori",
+	[OPCODE_LUI]     = "lui",
+	[OPCODE_COP0]    = "cop0",
+	[OPCODE_COP1]    = "cop1",
+	[OPCODE_SPECIAL2] = "special2",
+	[OPCODE_SPECIAL3] = "special3",
+	[OPCODE_LB]      = "lb",
+	[OPCODE_LH]      = "lh",
+	[OPCODE_LW]      = "lw",
+	[OPCODE_LBU]     = "lbu",
+	[OPCODE_LHU]     = "lhu",
+	[OPCODE_SB]      = "sb",
+	[OPCODE_SH]      = "sh",
+	[OPCODE_SW]      = "sw",
+	[OPCODE_LWC1]    = "lwc1",
+	[OPCODE_LDC1]    = "ldc1",
+	[OPCODE_SWC1]    = "swc1",
+	[OPCODE_SDC1]    = "sdc1",
+};
+
+const char *FUNCTION_NAMES[DISPATCH_SIZE] = {
+	[FUNC_SLL]     = "sll",
+	[FUNC_SRL]     = "srl",
+	[FUNC_SRA]     = "sra",
+	[FUNC_SLLV]    = "sllv",
+	[FUNC_SRLV]    = "srlv",
+	[FUNC_SRAV]    = "srav",
+	[FUNC_JR]      = "jr",
+	[FUNC_JALR]    = "jalr",
+	[FUNC_MOVZ]    = "movz",
+	[FUNC_MOVN]    = "movn",
+	[FUNC_SYSCALL] = "syscall",
+	[FUNC_MFHI]    = "mfhi",
+	[FUNC_MTHI]    = "mthi",
+	[FUNC_MFLO]    = "mflo",
+	[FUNC_MTLO]    = "mtlo",
+	[FUNC_MULT]    = "mult",
+	[FUNC_MULTU]   = "multu",
+	[FUNC_DIV]     = "div",
+	[FUNC_DIVU]    = "divu",
+	[FUNC_ADD]     = "add",
+	[FUNC_ADDU]    = "addu",
+	[FUNC_SUB]     = "sub",
+	[FUNC_SUBU]    = "subu",
+	[FUNC_AND]     = "and",
+	[FUNC_OR]      = "or",
+	[FUNC_XOR]     = "xor",
+	[FUNC_NOR]     = "nor",
+	[FUNC_SLT]     = "slt",
+	[FUNC_SLTU]    = "sltu",
+};
+
+const char *TARGET_NAMES[DISPATCH_SIZE] = {
+	[TARGET_BLTZ]   = "bltz",
+	[TARGET_BGEZ]   = "bgez",
+	[TARGET_BLTZAL] = "bltzal",
+	[TARGET_BGEZAL] = "bgezal",
+};
@@ -90,4 +90,13 @@ int decode_r_shamt(uint32_t instr);
  */
 int decode_r_funct(uint32_t instr);
 
+/* ----------------------------------------------------------------------------
+	Instruction Mnemonics 
+*/
+
+// mnemonic tables, keyed like the handler dispatch tables (NULL if unrecognized)
+extern const char *OPCODE_NAMES[];
+extern const char *FUNCTION_NAMES[];
+extern const char *TARGET_NAMES[];
+
 #endif // __DECODE_H
@@ -0,0 +1,246 @@
+/*
+ * devices.c
+ * Memory-mapped devices: console UART, interval timer, block device and
+ * exit port.
+ *
+ * Devices with latency (the timer, block transfers) schedule timed events
+ * rather than being polled from the simulation loop, so they cost nothing
+ * between events.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "shell.h"
+#include "cp0.h"
+#include "events.h"
+#include "mmio.h"
+#include "counters.h"
+#include "syscalls.h"
+#include "devices.h"
+
+// register window mapped for each device
+#define DEVICE_SIZE 0x100
+
+/* ----------------------------------------------------------------------------
+	UART
+*/
+
+// set once reading the console has reached end of file
+static int uart_eof;
+
+static uint32_t uart_read(void *unused, uint32_t offset) {
+	switch (offset) {
+	case UART_DATA: {
+		syscall_flush();
+		int c = getchar();
+		if (c == EOF) {
+			uart_eof = 1;
+			return 0xFFFFFFFF;
+		}
+		return (uint32_t) c;
+	}
+	case UART_STATUS:
+		return (uart_eof ? 0 : UART_RX_READY) | UART_TX_READY;
+	}
+	return 0;
+}
+
+static void uart_write(void *unused, uint32_t offset, uint32_t value) {
+	if (offset == UART_DATA) {
+		uint8_t byte = value & 0xFF;
+		console_write(&byte, 1);
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Interval Timer
+*/
+
+static struct {
+	uint32_t period;
+	uint32_t control;
+	uint32_t status;
+	uint32_t ticks;
+	TimedEvent event;
+} timer;
+
+static void timer_expire(void *unused) {
+	timer.ticks++;
+	timer.status |= TIMER_EXPIRED;
+	cp0_raise_interrupt(CAUSE_IP_HW(TIMER_IRQ));
+
+	// the period in effect now applies to the next expiration
+	if (timer.period != 0) {
+		event_schedule(&timer.event, timer.period);
+	}
+}
+
+static uint32_t timer_read(void *unused, uint32_t offset) {
+	switch (offset) {
+	case TIMER_PERIOD:  return timer.period;
+	case TIMER_CONTROL: return timer.control;
+	case TIMER_STATUS:  return timer.status;
+	case TIMER_TICKS:   return timer.ticks;
+	}
+	return 0;
+}
+
+static void timer_write(void *unused, uint32_t offset, uint32_t value) {
+	switch (offset) {
+	case TIMER_PERIOD:
+		timer.period = value;
+		break;
+	case TIMER_CONTROL:
+		timer.control = value & TIMER_ENABLE;
+		event_cancel(&timer.event);
+		if (timer.control & TIMER_ENABLE) {
+			timer.ticks = 0;
+			if (timer.period != 0) {
+				event_schedule(&timer.event, timer.period);
+			}
+		}
+		break;
+	case TIMER_STATUS:
+		if (value & TIMER_EXPIRED) {
+			timer.status &= ~TIMER_EXPIRED;
+			cp0_clear_interrupt(CAUSE_IP_HW(TIMER_IRQ));
+		}
+		break;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Block Device
+*/
+
+static struct {
+	int fd;
+	uint32_t sectors;
+	uint32_t sector;
+	uint32_t address;
+	uint32_t count;
+	uint32_t command;
+	uint32_t status;
+	TimedEvent event;
+} disk;
+
+/*
+ * block_transfer
+ * Carry out the latched command between the host file and guest memory.
+ * Returns 0 on success, -1 if the sectors or the guest buffer are out of
+ * range or the host I/O fails.
+ */
+static int block_transfer(void) {
+	uint64_t bytes = (uint64_t) disk.count * BLOCK_SECTOR_SIZE;
+	off_t offset = (off_t) disk.sector * BLOCK_SECTOR_SIZE;
+	uint32_t available;
+	uint8_t *buffer;
+	ssize_t done;
+
+	if ((uint64_t) disk.sector + disk.count > disk.sectors) {
+		return -1;
+	}
+
+	// reading from the disk writes guest memory, so text can't be the target
+	buffer = mem_span(disk.address, &available, disk.command == BLOCK_READ);
+	if (buffer == NULL || bytes > available) {
+		return -1;
+	}
+
+	if (disk.command == BLOCK_READ) {
+		done = pread(disk.fd, buffer, bytes, offset);
+	} else {
+		done = pwrite(disk.fd, buffer, bytes, offset);
+	}
+	return done == (ssize_t) bytes ? 0 : -1;
+}
+
+static void block_complete(void *unused) {
+	disk.status = block_transfer() == 0 ? BLOCK_DONE : BLOCK_ERROR;
+	cp0_raise_interrupt(CAUSE_IP_HW(BLOCK_IRQ));
+}
+
+static uint32_t block_read(void *unused, uint32_t offset) {
+	switch (offset) {
+	case BLOCK_SECTOR:  return disk.sector;
+	case BLOCK_ADDRESS: return disk.address;
+	case BLOCK_COUNT:   return disk.count;
+	case BLOCK_COMMAND: return disk.command;
+	case BLOCK_STATUS:  return disk.status;
+	case BLOCK_SECTORS: return disk.sectors;
+	}
+	return 0;
+}
+
+static void block_write(void *unused, uint32_t offset, uint32_t value) {
+	// the transfer registers are latched while a command is in flight
+	if (disk.status == BLOCK_BUSY && offset != BLOCK_STATUS) {
+		return;
+	}
+
+	switch (offset) {
+	case BLOCK_SECTOR:  disk.sector = value; break;
+	case BLOCK_ADDRESS: disk.address = value; break;
+	case BLOCK_COUNT:   disk.count = value; break;
+	case BLOCK_COMMAND:
+		disk.command = value;
+		if (value != BLOCK_READ && value != BLOCK_WRITE) {
+			disk.status = BLOCK_ERROR;
+			cp0_raise_interrupt(CAUSE_IP_HW(BLOCK_IRQ));
+			break;
+		}
+		disk.status = BLOCK_BUSY;
+		event_schedule(&disk.event, BLOCK_LATENCY + (uint64_t) disk.count * BLOCK_SECTOR_LATENCY);
+		break;
+	case BLOCK_STATUS:
+		// acknowledging a completion; a busy transfer carries on
+		if (disk.status != BLOCK_BUSY) {
+			disk.status = BLOCK_IDLE;
+			cp0_clear_interrupt(CAUSE_IP_HW(BLOCK_IRQ));
+		}
+		break;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Exit Port
+*/
+
+static void exit_write(void *unused, uint32_t offset, uint32_t value) {
+	if (offset == EXIT_CODE_PORT) {
+		EXIT_CODE = (int) value;
+		RUN_BIT = 0;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Device Setup
+	See module header file (devices.h) for detailed function comments.
+*/
+
+int devices_init(const char *disk_file) {
+	mmio_register(COUNTERS_BASE, COUNTERS_SIZE, counters_read, NULL, NULL);
+	mmio_register(UART_BASE, DEVICE_SIZE, uart_read, uart_write, NULL);
+	mmio_register(TIMER_BASE, DEVICE_SIZE, timer_read, timer_write, NULL);
+	mmio_register(EXIT_BASE, DEVICE_SIZE, NULL, exit_write, NULL);
+	event_init(&timer.event, timer_expire, NULL);
+
+	if (disk_file == NULL) {
+		return 0;
+	}
+
+	struct stat info;
+	disk.fd = open(disk_file, O_RDWR);
+	if (disk.fd < 0 || fstat(disk.fd, &info) != 0) {
+		return -1;
+	}
+	disk.sectors = info.st_size / BLOCK_SECTOR_SIZE;
+
+	mmio_register(BLOCK_BASE, DEVICE_SIZE, block_read, block_write, NULL);
+	event_init(&disk.event, block_complete, NULL);
+	return 0;
+}
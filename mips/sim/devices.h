@@ -0,0 +1,93 @@
+/*
+ * devices.h
+ * Memory-mapped devices: console UART, interval timer, block device and
+ * exit port, next to the performance counters (counters.h).
+ *
+ * All registers are 32-bit words. The timer and block device assert a
+ * hardware interrupt line in CP0 Cause until acknowledged; it is taken when
+ * unmasked and enabled in Status, or the guest can poll instead.
+ */
+
+#ifndef __DEVICES_H
+#define __DEVICES_H
+
+#include <stdint.h>
+
+/* ----------------------------------------------------------------------------
+	UART: console input and output
+*/
+
+#define UART_BASE 0xBFFF1000
+
+#define UART_DATA    0x00  // read: next input byte, write: output the low byte
+#define UART_STATUS  0x04  // UART_RX_READY | UART_TX_READY
+
+#define UART_RX_READY 0x1  // input hasn't reached end of file
+#define UART_TX_READY 0x2  // always set, output is buffered
+
+/* ----------------------------------------------------------------------------
+	Interval timer, counting retired instructions
+*/
+
+#define TIMER_BASE 0xBFFF2000
+
+#define TIMER_PERIOD   0x00  // instructions between expirations
+#define TIMER_CONTROL  0x04  // TIMER_ENABLE, writing restarts the period
+#define TIMER_STATUS   0x08  // TIMER_EXPIRED, write it back to acknowledge
+#define TIMER_TICKS    0x0C  // expirations since the timer was enabled
+
+#define TIMER_ENABLE   0x1
+#define TIMER_EXPIRED  0x1
+
+#define TIMER_IRQ 0  // hardware interrupt line (Cause IP2)
+
+/* ----------------------------------------------------------------------------
+	Block device backed by a host file, with DMA to guest memory
+*/
+
+#define BLOCK_BASE 0xBFFF3000
+
+#define BLOCK_SECTOR   0x00  // first sector of the transfer
+#define BLOCK_ADDRESS  0x04  // guest buffer address
+#define BLOCK_COUNT    0x08  // sectors to transfer
+#define BLOCK_COMMAND  0x0C  // write BLOCK_READ or BLOCK_WRITE to start
+#define BLOCK_STATUS   0x10  // BLOCK_IDLE ... BLOCK_ERROR, write to acknowledge
+#define BLOCK_SECTORS  0x14  // capacity in sectors
+
+#define BLOCK_READ  1
+#define BLOCK_WRITE 2
+
+#define BLOCK_IDLE  0
+#define BLOCK_BUSY  1
+#define BLOCK_DONE  2
+#define BLOCK_ERROR 3
+
+#define BLOCK_SECTOR_SIZE 512
+
+// a transfer completes this many instructions after it starts
+#define BLOCK_LATENCY        1000
+#define BLOCK_SECTOR_LATENCY  100
+
+#define BLOCK_IRQ 1  // hardware interrupt line (Cause IP3)
+
+/* ----------------------------------------------------------------------------
+	Exit port
+*/
+
+#define EXIT_BASE 0xBFFF4000
+
+#define EXIT_CODE_PORT 0x00  // write: halt with the value as exit code
+
+/* ----------------------------------------------------------------------------
+	Device Setup
+*/
+
+/*
+ * devices_init
+ * Map the counters, UART, timer and exit port, and the block device if
+ * disk names a host file to back it. Returns 0 on success, -1 if the disk
+ * file can't be opened.
+ */
+int devices_init(const char *disk);
+
+#endif // __DEVICES_H
@@ -0,0 +1,314 @@
+/*
+ * disasm.c
+ * Instruction disassembler.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "mips.h"
+#include "decode.h"
+#include "disasm.h"
+
+/* ----------------------------------------------------------------------------
+	Register Names
+*/
+
+static const char *REG_NAMES[32] = {
+	"zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+	"t0",   "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+	"s0",   "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+	"t8",   "t9", "k0", "k1", "gp", "sp", "fp", "ra"
+};
+
+/* ----------------------------------------------------------------------------
+	Disassembly by Instruction Format
+*/
+
+static void disasm_special(uint32_t instr, char *buf, size_t len) {
+	int func = decode_r_funct(instr);
+	const char *rs = REG_NAMES[decode_r_rs(instr)];
+	const char *rt = REG_NAMES[decode_r_rt(instr)];
+	const char *rd = REG_NAMES[decode_r_rd(instr)];
+	const char *name = FUNCTION_NAMES[func];
+
+	// rotates share the function codes of the logical right shifts
+	if (func == FUNC_SRL && decode_r_rs(instr) == FUNC_ROTATE) {
+		name = "rotr";
+	} else if (func == FUNC_SRLV && decode_r_shamt(instr) == FUNC_ROTATE) {
+		name = "rotrv";
+	}
+
+	switch (func) {
+	case FUNC_SLL:
+	case FUNC_SRL:
+	case FUNC_SRA:
+		snprintf(buf, len, "%s $%s, $%s, %d", name, rd, rt, decode_r_shamt(instr));
+		break;
+	case FUNC_SLLV:
+	case FUNC_SRLV:
+	case FUNC_SRAV:
+		snprintf(buf, len, "%s $%s, $%s, $%s", name, rd, rt, rs);
+		break;
+	case FUNC_JR:
+	case FUNC_MTHI:
+	case FUNC_MTLO:
+		snprintf(buf, len, "%s $%s", name, rs);
+		break;
+	case FUNC_JALR:
+		snprintf(buf, len, "%s $%s, $%s", name, rd, rs);
+		break;
+	case FUNC_SYSCALL:
+		snprintf(buf, len, "%s", name);
+		break;
+	case FUNC_MFHI:
+	case FUNC_MFLO:
+		snprintf(buf, len, "%s $%s", name, rd);
+		break;
+	case FUNC_MULT:
+	case FUNC_MULTU:
+	case FUNC_DIV:
+	case FUNC_DIVU:
+		snprintf(buf, len, "%s $%s, $%s", name, rs, rt);
+		break;
+	default:
+		if (name) {
+			snprintf(buf, len, "%s $%s, $%s, $%s", name, rd, rs, rt);
+		} else {
+			snprintf(buf, len, ".word 0x%08x", instr);
+		}
+		break;
+	}
+}
+
+static void disasm_regimm(uint32_t instr, uint32_t pc, char *buf, size_t len) {
+	const char *name = TARGET_NAMES[decode_i_rt(instr)];
+	int32_t offset = (int32_t) (decode_i_immediate(instr) << 2);
+
+	if (name) {
+		snprintf(buf, len, "%s $%s, 0x%08x", name, REG_NAMES[decode_i_rs(instr)], pc + offset);
+	} else {
+		snprintf(buf, len, ".word 0x%08x", instr);
+	}
+}
+
+static void disasm_special2(uint32_t instr, char *buf, size_t len) {
+	const char *rs = REG_NAMES[decode_r_rs(instr)];
+	const char *rt = REG_NAMES[decode_r_rt(instr)];
+	const char *rd = REG_NAMES[decode_r_rd(instr)];
+
+	switch (decode_r_funct(instr)) {
+	case FUNC2_MUL:
+		snprintf(buf, len, "mul $%s, $%s, $%s", rd, rs, rt);
+		break;
+	case FUNC2_CLZ:
+		snprintf(buf, len, "clz $%s, $%s", rd, rs);
+		break;
+	case FUNC2_CLO:
+		snprintf(buf, len, "clo $%s, $%s", rd, rs);
+		break;
+	default:
+		snprintf(buf, len, ".word 0x%08x", instr);
+		break;
+	}
+}
+
+static void disasm_special3(uint32_t instr, char *buf, size_t len) {
+	const char *rs = REG_NAMES[decode_r_rs(instr)];
+	const char *rt = REG_NAMES[decode_r_rt(instr)];
+	const char *rd = REG_NAMES[decode_r_rd(instr)];
+	int pos = decode_r_shamt(instr);
+
+	switch (decode_r_funct(instr)) {
+	case FUNC3_EXT:
+		snprintf(buf, len, "ext $%s, $%s, %d, %d", rt, rs, pos, decode_r_rd(instr) + 1);
+		break;
+	case FUNC3_INS:
+		snprintf(buf, len, "ins $%s, $%s, %d, %d", rt, rs, pos, decode_r_rd(instr) - pos + 1);
+		break;
+	case FUNC3_BSHFL:
+		if (pos == BSHFL_SEB || pos == BSHFL_SEH || pos == BSHFL_WSBH) {
+			snprintf(buf, len, "%s $%s, $%s",
+				pos == BSHFL_SEB ? "seb" : pos == BSHFL_SEH ? "seh" : "wsbh", rd, rt);
+			break;
+		}
+		// fall through
+	default:
+		snprintf(buf, len, ".word 0x%08x", instr);
+		break;
+	case FUNC3_RDHWR:
+		snprintf(buf, len, "rdhwr $%s, $%d", rt, decode_r_rd(instr));
+		break;
+	}
+}
+
+static void disasm_cop0(uint32_t instr, char *buf, size_t len) {
+	int sub = decode_r_rs(instr);
+
+	if (sub == COP0_MF || sub == COP0_MT) {
+		snprintf(buf, len, "%s $%s, $%d", sub == COP0_MF ? "mfc0" : "mtc0",
+			REG_NAMES[decode_r_rt(instr)], decode_r_rd(instr));
+	} else if (sub == COP0_CO && decode_r_funct(instr) == FUNC_CO_ERET) {
+		snprintf(buf, len, "eret");
+	} else if (sub == COP0_CO && decode_r_funct(instr) == FUNC_CO_TLBR) {
+		snprintf(buf, len, "tlbr");
+	} else if (sub == COP0_CO && decode_r_funct(instr) == FUNC_CO_TLBWI) {
+		snprintf(buf, len, "tlbwi");
+	} else if (sub == COP0_CO && decode_r_funct(instr) == FUNC_CO_TLBWR) {
+		snprintf(buf, len, "tlbwr");
+	} else if (sub == COP0_CO && decode_r_funct(instr) == FUNC_CO_TLBP) {
+		snprintf(buf, len, "tlbp");
+	} else {
+		snprintf(buf, len, ".word 0x%08x", instr);
+	}
+}
+
+static const char *FP_CONDITIONS[16] = {
+	"f", "un", "eq", "ueq", "olt", "ult", "ole", "ule",
+	"sf", "ngle", "seq", "ngl", "lt", "nge", "le", "ngt"
+};
+
+static void disasm_cop1(uint32_t instr, uint32_t pc, char *buf, size_t len) {
+	int sub = decode_r_rs(instr);
+	int func = decode_r_funct(instr);
+	int ft = decode_r_rt(instr), fs = decode_r_rd(instr), fd = decode_r_shamt(instr);
+	const char *fmt = sub == COP1_FMT_S ? "s" : sub == COP1_FMT_D ? "d" : "w";
+	const char *name = NULL;
+
+	switch (sub) {
+	case COP1_MF:
+	case COP1_CF:
+	case COP1_MT:
+	case COP1_CT:
+		snprintf(buf, len, "%s $%s, $%s%d", sub == COP1_MF ? "mfc1" : sub == COP1_CF ? "cfc1" :
+			sub == COP1_MT ? "mtc1" : "ctc1", REG_NAMES[ft],
+			sub == COP1_MF || sub == COP1_MT ? "f" : "", fs);
+		return;
+	case COP1_BC:
+		snprintf(buf, len, "bc1%s %d, 0x%08x", ft & 1 ? "t" : "f", ft >> 2,
+			pc + (decode_i_immediate(instr) << 2));
+		return;
+	case COP1_FMT_S:
+	case COP1_FMT_D:
+	case COP1_FMT_W:
+		break;
+	default:
+		snprintf(buf, len, ".word 0x%08x", instr);
+		return;
+	}
+
+	if (func >= FUNC_FP_C && sub != COP1_FMT_W) {
+		snprintf(buf, len, "c.%s.%s %d, $f%d, $f%d", FP_CONDITIONS[func - FUNC_FP_C], fmt,
+			fd >> 2, fs, ft);
+		return;
+	}
+
+	switch (func) {
+	case FUNC_FP_ADD: name = "add"; break;
+	case FUNC_FP_SUB: name = "sub"; break;
+	case FUNC_FP_MUL: name = "mul"; break;
+	case FUNC_FP_DIV: name = "div"; break;
+	case FUNC_FP_SQRT: name = "sqrt"; break;
+	case FUNC_FP_ABS: name = "abs"; break;
+	case FUNC_FP_MOV: name = "mov"; break;
+	case FUNC_FP_NEG: name = "neg"; break;
+	case FUNC_FP_ROUND_W: name = "round.w"; break;
+	case FUNC_FP_TRUNC_W: name = "trunc.w"; break;
+	case FUNC_FP_CEIL_W: name = "ceil.w"; break;
+	case FUNC_FP_FLOOR_W: name = "floor.w"; break;
+	case FUNC_FP_CVT_S: name = "cvt.s"; break;
+	case FUNC_FP_CVT_D: name = "cvt.d"; break;
+	case FUNC_FP_CVT_W: name = "cvt.w"; break;
+	}
+
+	if (name == NULL) {
+		snprintf(buf, len, ".word 0x%08x", instr);
+	} else if (func <= FUNC_FP_DIV) {
+		snprintf(buf, len, "%s.%s $f%d, $f%d, $f%d", name, fmt, fd, fs, ft);
+	} else {
+		snprintf(buf, len, "%s.%s $f%d, $f%d", name, fmt, fd, fs);
+	}
+}
+
+static void disasm_opcode(uint32_t instr, uint32_t pc, char *buf, size_t len) {
+	int op = decode_opcode(instr);
+	const char *rs = REG_NAMES[decode_i_rs(instr)];
+	const char *rt = REG_NAMES[decode_i_rt(instr)];
+	const char *name = OPCODE_NAMES[op];
+	int16_t immediate = decode_i_immediate(instr);
+
+	switch (op) {
+	case OPCODE_J:
+	case OPCODE_JAL:
+		snprintf(buf, len, "%s 0x%08x", name,
+			(pc & MASK_PC_HIGH) | (decode_j_target(instr) << 2));
+		break;
+	case OPCODE_BEQ:
+	case OPCODE_BNE:
+		// branch offsets are relative to the branch itself in this simulator
+		snprintf(buf, len, "%s $%s, $%s, 0x%08x", name, rs, rt, pc + (immediate << 2));
+		break;
+	case OPCODE_BLEZ:
+	case OPCODE_BGTZ:
+		snprintf(buf, len, "%s $%s, 0x%08x", name, rs, pc + (immediate << 2));
+		break;
+	case OPCODE_ANDI:
+	case OPCODE_ORI:
+	case OPCODE_XORI:
+		snprintf(buf, len, "%s $%s, $%s, 0x%x", name, rt, rs, (uint16_t) immediate);
+		break;
+	case OPCODE_LUI:
+		snprintf(buf, len, "%s $%s, 0x%x", name, rt, (uint16_t) immediate);
+		break;
+	case OPCODE_LB:
+	case OPCODE_LH:
+	case OPCODE_LW:
+	case OPCODE_LBU:
+	case OPCODE_LHU:
+	case OPCODE_SB:
+	case OPCODE_SH:
+	case OPCODE_SW:
+		snprintf(buf, len, "%s $%s, %d($%s)", name, rt, immediate, rs);
+		break;
+	case OPCODE_LWC1:
+	case OPCODE_LDC1:
+	case OPCODE_SWC1:
+	case OPCODE_SDC1:
+		snprintf(buf, len, "%s $f%d, %d($%s)", name, decode_i_rt(instr), immediate, rs);
+		break;
+	default:
+		if (name) {
+			snprintf(buf, len, "%s $%s, $%s, %d", name, rt, rs, immediate);
+		} else {
+			snprintf(buf, len, ".word 0x%08x", instr);
+		}
+		break;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Disassembler Entry Point
+	See module header file (disasm.h) for detailed function comments.
+*/
+
+void disasm(uint32_t instr, uint32_t pc, char *buf, size_t len) {
+	int op = decode_opcode(instr);
+
+	if (instr == 0) {
+		snprintf(buf, len, "nop");
+	} else if (op == OPCODE_SPECIAL) {
+		disasm_special(instr, buf, len);
+	} else if (op == OPCODE_REGIMM) {
+		disasm_regimm(instr, pc, buf, len);
+	} else if (op == OPCODE_COP0) {
+		disasm_cop0(instr, buf, len);
+	} else if (op == OPCODE_COP1) {
+		disasm_cop1(instr, pc, buf, len);
+	} else if (op == OPCODE_SPECIAL2) {
+		disasm_special2(instr, buf, len);
+	} else if (op == OPCODE_SPECIAL3) {
+		disasm_special3(instr, buf, len);
+	} else {
+		disasm_opcode(instr, pc, buf, len);
+	}
+}
@@ -0,0 +1,19 @@
+/*
+ * disasm.h
+ * Instruction disassembler.
+ */
+
+#ifndef __DISASM_H
+#define __DISASM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * disasm
+ * Write assembly text for instr, located at address pc, into buf.
+ * Branch and jump targets are printed as absolute addresses.
+ */
+void disasm(uint32_t instr, uint32_t pc, char *buf, size_t len);
+
+#endif // __DISASM_H
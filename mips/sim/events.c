@@ -0,0 +1,178 @@
+/*
+ * events.c
+ * Event scheduler keyed by instruction count.
+ *
+ * Pending events live in a timing wheel of WHEEL_SLOTS slots, each covering
+ * 2^SLOT_BITS instructions, so the wheel spans HORIZON instructions from
+ * the slot of the current instruction. Events due beyond the horizon wait
+ * in a sorted far list and move onto the wheel as it turns. Scheduling and
+ * cancelling near events is O(1); finding the next due event scans forward
+ * from the current slot, and only when an event fires or the earliest one
+ * is cancelled.
+ */
+
+#include <stdint.h>
+
+#include "shell.h"
+#include "events.h"
+
+uint64_t EVENT_NEXT = UINT64_MAX;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define SLOT_BITS   6
+#define WHEEL_BITS 10
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define HORIZON     ((uint64_t) WHEEL_SLOTS << SLOT_BITS)
+
+#define SLOT(when) (((when) >> SLOT_BITS) & (WHEEL_SLOTS - 1))
+
+static TimedEvent *wheel[WHEEL_SLOTS];
+
+// events due at or after wheel_base + HORIZON, earliest first
+static TimedEvent *far;
+
+// start of the slot holding the current instruction count
+static uint64_t wheel_base;
+
+// the event due at EVENT_NEXT
+static TimedEvent *next_event;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+/*
+ * link_at
+ * Link event into a list in front of *position.
+ */
+static void link_at(TimedEvent **position, TimedEvent *event) {
+	event->next = *position;
+	if (event->next) {
+		event->next->link = &event->next;
+	}
+	*position = event;
+	event->link = position;
+}
+
+static void unlink_event(TimedEvent *event) {
+	*event->link = event->next;
+	if (event->next) {
+		event->next->link = event->link;
+	}
+	event->link = NULL;
+}
+
+/*
+ * insert
+ * Add event to its wheel slot, or in order to the far list.
+ */
+static void insert(TimedEvent *event) {
+	TimedEvent **position = &far;
+
+	if (event->when < wheel_base + HORIZON) {
+		link_at(&wheel[SLOT(event->when)], event);
+		return;
+	}
+
+	while (*position && (*position)->when <= event->when) {
+		position = &(*position)->next;
+	}
+	link_at(position, event);
+}
+
+/*
+ * advance
+ * Turn the wheel to the current instruction count. Every event on the
+ * wheel is due at or after it, so moving the base keeps them in range.
+ */
+static void advance(void) {
+	wheel_base = INSTRUCTION_COUNT & ~(((uint64_t) 1 << SLOT_BITS) - 1);
+
+	while (far && far->when < wheel_base + HORIZON) {
+		TimedEvent *event = far;
+		unlink_event(event);
+		insert(event);
+	}
+}
+
+/*
+ * find_next
+ * Set next_event and EVENT_NEXT to the earliest pending event: the
+ * earliest in the first non-empty slot, else the head of the far list.
+ */
+static void find_next(void) {
+	uint64_t slot_start = wheel_base;
+
+	next_event = NULL;
+	for (int i = 0; i < WHEEL_SLOTS && next_event == NULL; i++) {
+		for (TimedEvent *event = wheel[SLOT(slot_start)]; event; event = event->next) {
+			if (next_event == NULL || event->when < next_event->when) {
+				next_event = event;
+			}
+		}
+		slot_start += (uint64_t) 1 << SLOT_BITS;
+	}
+
+	if (next_event == NULL) {
+		next_event = far;
+	}
+	EVENT_NEXT = next_event ? next_event->when : UINT64_MAX;
+}
+
+/* ----------------------------------------------------------------------------
+	Event Scheduler Interface
+	See module header file (events.h) for detailed function comments.
+*/
+
+void event_init(TimedEvent *event, EventHandler handler, void *arg) {
+	event->handler = handler;
+	event->arg = arg;
+	event->next = NULL;
+	event->link = NULL;
+}
+
+void event_schedule(TimedEvent *event, uint64_t delay) {
+	int was_next = event == next_event;
+
+	if (event_pending(event)) {
+		unlink_event(event);
+	}
+
+	event->when = INSTRUCTION_COUNT + delay;
+	advance();
+	insert(event);
+
+	if (was_next) {
+		find_next();
+	} else if (event->when < EVENT_NEXT) {
+		next_event = event;
+		EVENT_NEXT = event->when;
+	}
+}
+
+void event_cancel(TimedEvent *event) {
+	if (!event_pending(event)) {
+		return;
+	}
+
+	unlink_event(event);
+	if (event == next_event) {
+		find_next();
+	}
+}
+
+void event_run(void) {
+	while (EVENT_NEXT <= INSTRUCTION_COUNT) {
+		TimedEvent *event = next_event;
+
+		unlink_event(event);
+		advance();
+		find_next();
+
+		// the handler may schedule more events, including this one
+		event->handler(event->arg);
+	}
+}
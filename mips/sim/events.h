@@ -0,0 +1,64 @@
+/*
+ * events.h
+ * Event scheduler keyed by instruction count.
+ *
+ * Devices and timers schedule callbacks a number of instructions ahead.
+ * The run loop compares the instruction count against EVENT_NEXT once per
+ * instruction and calls event_run only when an event is due.
+ */
+
+#ifndef __EVENTS_H
+#define __EVENTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void (*EventHandler)(void *arg);
+
+// an event is owned by its user, typically embedded in the device state
+typedef struct TimedEvent_Struct {
+	uint64_t when;                        // instruction count it is due at
+	EventHandler handler;
+	void *arg;
+	struct TimedEvent_Struct *next;       // in its wheel slot or the far list
+	struct TimedEvent_Struct **link;      // the pointer to this event, NULL when idle
+} TimedEvent;
+
+// instruction count of the earliest pending event, UINT64_MAX if none
+extern uint64_t EVENT_NEXT;
+
+/*
+ * event_init
+ * Set up an idle event that calls handler(arg) when it fires.
+ */
+void event_init(TimedEvent *event, EventHandler handler, void *arg);
+
+/*
+ * event_schedule
+ * Fire event after delay more instructions have retired, replacing any
+ * earlier schedule. With delay 0 it fires before the next instruction.
+ */
+void event_schedule(TimedEvent *event, uint64_t delay);
+
+/*
+ * event_cancel
+ * Remove event from the schedule if it is pending.
+ */
+void event_cancel(TimedEvent *event);
+
+/*
+ * event_pending
+ * Whether event is scheduled and hasn't fired.
+ */
+static inline int event_pending(const TimedEvent *event) {
+	return event->link != NULL;
+}
+
+/*
+ * event_run
+ * Fire every event due at the current instruction count, in order of due
+ * time. Handlers run between instructions and may schedule events.
+ */
+void event_run(void);
+
+#endif // __EVENTS_H
@@ -0,0 +1,475 @@
+/*
+ * fpu.c
+ * Coprocessor 1: MIPS32 floating-point unit.
+ *
+ * Single and double operations are host float and double arithmetic, which
+ * compiles to SSE2 scalar instructions on x86-64. The guest rounding mode is
+ * installed as the host rounding mode only for the length of each guest
+ * operation, so the simulator's own floating point (statistics, printing
+ * floats for the guest) always runs in the host mode. The host exception
+ * flags raised by the operation are collected into the FCSR flag and cause
+ * fields.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fenv.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "shell.h"
+#include "decode.h"
+#include "stats.h"
+#include "retire.h"
+#include "fpu.h"
+#include "cp0.h"
+#include "tlb.h"
+
+FPU_State FPU;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+// FIR: single, double and word formats, MIPS32 release 2
+#define FIR_VALUE 0x00130000
+
+// integer result of an invalid conversion
+#define WORD_INVALID 0x7FFFFFFF
+
+// MIPS flag bits (also the cause bits, shifted left by FCSR_CAUSE_SHIFT)
+#define FLAG_INEXACT   0x04
+#define FLAG_UNDERFLOW 0x08
+#define FLAG_OVERFLOW  0x10
+#define FLAG_DIVIDE    0x20
+#define FLAG_INVALID   0x40
+
+#define FCSR_CAUSE_SHIFT 10
+
+static const int ROUNDING_MODES[4] = { FE_TONEAREST, FE_TOWARDZERO, FE_UPWARD, FE_DOWNWARD };
+
+static float get_s(int r) {
+	float value;
+	memcpy(&value, &FPU.FPR[r], sizeof(value));
+	return value;
+}
+
+static void set_s(int r, float value) {
+	memcpy(&FPU.FPR[r], &value, sizeof(value));
+}
+
+static double get_d(int r) {
+	uint64_t bits = FPU.FPR[r & ~1] | ((uint64_t) FPU.FPR[r | 1] << 32);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void set_d(int r, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	FPU.FPR[r & ~1] = (uint32_t) bits;
+	FPU.FPR[r | 1] = (uint32_t) (bits >> 32);
+}
+
+// condition code cc: FCSR bit 23 for cc 0, bits 25-31 for cc 1-7
+static int get_fcc(int cc) {
+	return (FPU.FCSR >> (cc ? 24 + cc : 23)) & 1;
+}
+
+static void set_fcc(int cc, int value) {
+	uint32_t bit = 1u << (cc ? 24 + cc : 23);
+	FPU.FCSR = value ? FPU.FCSR | bit : FPU.FCSR & ~bit;
+}
+
+/*
+ * guest_rounding
+ * Install the guest rounding mode, and clear the host exception flags, for
+ * a guest operation. Returns the host rounding mode, for host_rounding.
+ */
+static int guest_rounding(void) {
+	int host = fegetround();
+	int guest = ROUNDING_MODES[FPU.FCSR & FCSR_RM];
+
+	if (guest != host) {
+		fesetround(guest);
+	}
+	feclearexcept(FE_ALL_EXCEPT);
+	return host;
+}
+
+// put back the host rounding mode after a guest operation
+static void host_rounding(int host) {
+	if (ROUNDING_MODES[FPU.FCSR & FCSR_RM] != host) {
+		fesetround(host);
+	}
+}
+
+/*
+ * signalling
+ * Whether value is a signalling NaN: the quiet bit (the top fraction bit)
+ * is clear. Single operands are widened to double, which quiets them, but
+ * the widening itself raises Invalid.
+ */
+static int signalling(double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return isnan(value) && !(bits & 0x0008000000000000ULL);
+}
+
+/*
+ * record_flags
+ * Set the FCSR cause field, and accumulate the sticky flags, from the host
+ * exceptions raised since the last feclearexcept.
+ */
+static void record_flags(void) {
+	int raised = fetestexcept(FE_ALL_EXCEPT);
+	uint32_t flags = 0;
+
+	flags |= raised & FE_INEXACT   ? FLAG_INEXACT   : 0;
+	flags |= raised & FE_UNDERFLOW ? FLAG_UNDERFLOW : 0;
+	flags |= raised & FE_OVERFLOW  ? FLAG_OVERFLOW  : 0;
+	flags |= raised & FE_DIVBYZERO ? FLAG_DIVIDE    : 0;
+	flags |= raised & FE_INVALID   ? FLAG_INVALID   : 0;
+
+	FPU.FCSR = (FPU.FCSR & ~FCSR_CAUSE) | (flags << FCSR_CAUSE_SHIFT) | flags;
+}
+
+/*
+ * to_word
+ * Convert value, already rounded to rounded, to a word, or the invalid result
+ * if it is NaN or out of range. trunc, ceil and friends never raise Inexact
+ * on the host, so it is raised here when rounding changed the value.
+ */
+static uint32_t to_word(double rounded, double value) {
+	if (isnan(rounded) || rounded >= 2147483648.0 || rounded < -2147483648.0) {
+		feraiseexcept(FE_INVALID);
+		return WORD_INVALID;
+	}
+	if (rounded != value) {
+		feraiseexcept(FE_INEXACT);
+	}
+	return (uint32_t) (int32_t) rounded;
+}
+
+/*
+ * fp_compare
+ * c.cond: condition bits 2, 1 and 0 select less than, equal and unordered.
+ * Signalling NaNs raise Invalid; with condition bit 3 (the signalling
+ * compares) so do quiet NaNs.
+ */
+static int fp_compare(double a, double b, int cond) {
+	if (isnan(a) || isnan(b)) {
+		if ((cond & 8) || signalling(a) || signalling(b)) {
+			feraiseexcept(FE_INVALID);
+		}
+		return cond & 1;
+	}
+	return ((cond & 4) && a < b) || ((cond & 2) && a == b);
+}
+
+/*
+ * fp_arithmetic
+ * Arithmetic, conversion and compare operations of the S and D formats, in
+ * the guest rounding mode.
+ */
+static int fp_arithmetic(uint32_t instr, int fmt) {
+	int func = decode_r_funct(instr);
+	int ft = decode_r_rt(instr);
+	int fs = decode_r_rd(instr);
+	int fd = decode_r_shamt(instr);
+	int dbl = fmt == COP1_FMT_D;
+
+	double a, b = 0.0, result;
+
+	// moves and sign changes only touch bits, so NaN payloads survive
+	if (func == FUNC_FP_MOV || func == FUNC_FP_ABS || func == FUNC_FP_NEG) {
+		int high = dbl ? fs | 1 : fs;
+		if (dbl) {
+			FPU.FPR[fd & ~1] = FPU.FPR[fs & ~1];
+		}
+		FPU.FPR[dbl ? fd | 1 : fd] = func == FUNC_FP_MOV ? FPU.FPR[high] :
+			func == FUNC_FP_ABS ? FPU.FPR[high] & 0x7FFFFFFF : FPU.FPR[high] ^ 0x80000000;
+		return STATUS_OK;
+	}
+
+	// operands, widened to double; the single operations round back exactly.
+	// Widening a signalling NaN raises Invalid, so ft is only read by the
+	// operations that have a second operand.
+	a = dbl ? get_d(fs) : get_s(fs);
+	if (func <= FUNC_FP_DIV || func >= FUNC_FP_C) {
+		b = dbl ? get_d(ft) : get_s(ft);
+	}
+
+	if (func >= FUNC_FP_C) {
+		// the condition code is in the top bits of the fd field
+		set_fcc(fd >> 2, fp_compare(a, b, func - FUNC_FP_C));
+		record_flags();
+		return STATUS_OK;
+	}
+
+	switch (func) {
+	case FUNC_FP_ADD:
+		result = dbl ? a + b : (double) ((float) a + (float) b);
+		break;
+	case FUNC_FP_SUB:
+		result = dbl ? a - b : (double) ((float) a - (float) b);
+		break;
+	case FUNC_FP_MUL:
+		result = dbl ? a * b : (double) ((float) a * (float) b);
+		break;
+	case FUNC_FP_DIV:
+		result = dbl ? a / b : (double) ((float) a / (float) b);
+		break;
+	case FUNC_FP_SQRT:
+		result = dbl ? sqrt(a) : (double) sqrtf((float) a);
+		break;
+	case FUNC_FP_ROUND_W:
+		// round to nearest even whatever the rounding mode
+		FPU.FPR[fd] = to_word(a - remainder(a, 1.0), a);
+		record_flags();
+		return STATUS_OK;
+	case FUNC_FP_TRUNC_W:
+		FPU.FPR[fd] = to_word(trunc(a), a);
+		record_flags();
+		return STATUS_OK;
+	case FUNC_FP_CEIL_W:
+		FPU.FPR[fd] = to_word(ceil(a), a);
+		record_flags();
+		return STATUS_OK;
+	case FUNC_FP_FLOOR_W:
+		FPU.FPR[fd] = to_word(floor(a), a);
+		record_flags();
+		return STATUS_OK;
+	case FUNC_FP_CVT_W:
+		// current rounding mode
+		FPU.FPR[fd] = to_word(rint(a), a);
+		record_flags();
+		return STATUS_OK;
+	case FUNC_FP_CVT_S:
+		// cvt.s.s is reserved
+		if (!dbl) {
+			return STATUS_ERR;
+		}
+		set_s(fd, (float) a);
+		record_flags();
+		return STATUS_OK;
+	case FUNC_FP_CVT_D:
+		// cvt.d.d is reserved
+		if (dbl) {
+			return STATUS_ERR;
+		}
+		set_d(fd, a);
+		record_flags();
+		return STATUS_OK;
+	default:
+		return STATUS_ERR;
+	}
+
+	if (dbl) {
+		set_d(fd, result);
+	} else {
+		set_s(fd, (float) result);
+	}
+	record_flags();
+	return STATUS_OK;
+}
+
+/*
+ * fp_convert_word
+ * Conversions from the W format, in the guest rounding mode.
+ */
+static int fp_convert_word(uint32_t instr) {
+	int32_t value = (int32_t) FPU.FPR[decode_r_rd(instr)];
+	int fd = decode_r_shamt(instr);
+
+	switch (decode_r_funct(instr)) {
+	case FUNC_FP_CVT_S:
+		set_s(fd, (float) value);
+		break;
+	case FUNC_FP_CVT_D:
+		set_d(fd, (double) value);
+		break;
+	default:
+		return STATUS_ERR;
+	}
+	record_flags();
+	return STATUS_OK;
+}
+
+/*
+ * fp_read_control
+ * cfc1: FIR, FCCR (the condition codes packed) or FCSR.
+ */
+static uint32_t fp_read_control(int fs) {
+	switch (fs) {
+	case FCR_FIR:
+		return FIR_VALUE;
+	case FCR_FCCR:
+		return ((FPU.FCSR >> 24) & 0xFE) | ((FPU.FCSR >> 23) & 1);
+	case FCR_FCSR:
+		return FPU.FCSR;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * fp_write_control
+ * ctc1: FCCR or FCSR.
+ */
+static void fp_write_control(int fs, uint32_t value) {
+	if (fs == FCR_FCCR) {
+		FPU.FCSR = (FPU.FCSR & ~(FCSR_FCC0 | FCSR_FCC1_7)) |
+			((value & 1) << 23) | ((value & 0xFE) << 24);
+	} else if (fs == FCR_FCSR) {
+		FPU.FCSR = value & FCSR_WRITABLE;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Instruction Handlers
+	See module header file (fpu.h) for detailed function comments.
+*/
+
+int handle_cop1(uint32_t instr) {
+	int fmt = decode_r_rs(instr);
+	int rt  = decode_r_rt(instr);
+	int fs  = decode_r_rd(instr);
+	int status = STATUS_OK;
+	int host;
+
+	switch (fmt) {
+	case COP1_MF:
+		NEXT_STATE.REGS[rt] = FPU.FPR[fs];
+		break;
+	case COP1_CF:
+		NEXT_STATE.REGS[rt] = fp_read_control(fs);
+		break;
+	case COP1_MT:
+		FPU.FPR[fs] = CURRENT_STATE.REGS[rt];
+		break;
+	case COP1_CT:
+		fp_write_control(fs, CURRENT_STATE.REGS[rt]);
+		break;
+	case COP1_BC:
+		// bc1f/bc1t: the rt field holds the condition code and true/false bit
+		if (get_fcc(rt >> 2) == (rt & 1)) {
+			// offsets are relative to the branch itself in this simulator
+			NEXT_STATE.PC = CURRENT_STATE.PC + ((int32_t) decode_i_immediate(instr) << 2);
+			STATS.branch_taken++;
+			RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
+		} else {
+			NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+			STATS.branch_not_taken++;
+			RETIRE_FLAG(RECORD_BRANCH);
+		}
+		return STATUS_OK;
+	case COP1_FMT_S:
+	case COP1_FMT_D:
+		host = guest_rounding();
+		status = fp_arithmetic(instr, fmt);
+		host_rounding(host);
+		break;
+	case COP1_FMT_W:
+		host = guest_rounding();
+		status = fp_convert_word(instr);
+		host_rounding(host);
+		break;
+	default:
+		status = STATUS_ERR;
+		break;
+	}
+
+	if (status != STATUS_OK) {
+		return exception_raise(EXC_RI, 0);
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return status;
+}
+
+int handle_lwc1(uint32_t instr) {
+	uint32_t address = CURRENT_STATE.REGS[decode_i_rs(instr)] + (int32_t) decode_i_immediate(instr);
+
+	if (address & 3) {
+		return exception_raise(EXC_ADEL, address);
+	}
+
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
+	RETIRE_MEM(address);
+	FPU.FPR[decode_i_rt(instr)] = mem_read_32(address);
+
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+	return STATUS_OK;
+}
+
+int handle_ldc1(uint32_t instr) {
+	uint32_t address = CURRENT_STATE.REGS[decode_i_rs(instr)] + (int32_t) decode_i_immediate(instr);
+	int ft = decode_i_rt(instr);
+
+	if (address & 7) {
+		return exception_raise(EXC_ADEL, address);
+	}
+
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
+	// one record: an aligned doubleword never spans a cache line
+	RETIRE_MEM(address);
+	FPU.FPR[ft & ~1] = mem_read_32(address);
+	FPU.FPR[ft | 1] = mem_read_32(address + 4);
+
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+	return STATUS_OK;
+}
+
+int handle_swc1(uint32_t instr) {
+	uint32_t address = CURRENT_STATE.REGS[decode_i_rs(instr)] + (int32_t) decode_i_immediate(instr);
+
+	if (address & 3) {
+		return exception_raise(EXC_ADES, address);
+	}
+
+	if (TLB_ENABLED && tlb_translate(&address, TLB_STORE)) {
+		return STATUS_ERR;
+	}
+
+	RETIRE_STORE(address);
+	mem_write_32(address, FPU.FPR[decode_i_rt(instr)]);
+
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+	return STATUS_OK;
+}
+
+int handle_sdc1(uint32_t instr) {
+	uint32_t address = CURRENT_STATE.REGS[decode_i_rs(instr)] + (int32_t) decode_i_immediate(instr);
+	int ft = decode_i_rt(instr);
+
+	if (address & 7) {
+		return exception_raise(EXC_ADES, address);
+	}
+
+	if (TLB_ENABLED && tlb_translate(&address, TLB_STORE)) {
+		return STATUS_ERR;
+	}
+
+	RETIRE_STORE(address);
+	mem_write_32(address, FPU.FPR[ft & ~1]);
+	mem_write_32(address + 4, FPU.FPR[ft | 1]);
+
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+	return STATUS_OK;
+}
+
+void fpu_restore(const FPU_State *state) {
+	FPU = *state;
+}
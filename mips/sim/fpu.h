@@ -0,0 +1,55 @@
+/*
+ * fpu.h
+ * Coprocessor 1: MIPS32 floating-point unit.
+ */
+
+#ifndef __FPU_H
+#define __FPU_H
+
+#include <stdint.h>
+
+#define FPU_REGS 32
+
+// FCSR fields
+#define FCSR_RM      0x00000003  // rounding mode: nearest, zero, +inf, -inf
+#define FCSR_FLAGS   0x0000007C  // sticky flags: inexact, underflow, overflow, divide, invalid
+#define FCSR_CAUSE   0x0003F000  // cause of the last operation
+#define FCSR_FCC0    0x00800000  // condition code 0
+#define FCSR_FCC1_7  0xFE000000  // condition codes 1-7
+#define FCSR_WRITABLE (FCSR_RM | FCSR_FLAGS | 0x00000F80 | FCSR_CAUSE | \
+                       0x01000000 | FCSR_FCC0 | FCSR_FCC1_7)
+
+typedef struct FPU_State_Struct {
+	uint32_t FPR[FPU_REGS];  // doubles use even/odd pairs, low word in the even register
+	uint32_t FCSR;           // control and status
+} FPU_State;
+
+// FPU state; instructions read their operands before writing, so it is not
+// double-buffered like the integer registers
+extern FPU_State FPU;
+
+/*
+ * handle_cop1
+ * Coprocessor 1 operations: moves, branches, arithmetic, conversions and
+ * compares.
+ * Opcode: 17
+ */
+int handle_cop1(uint32_t instr);
+
+/*
+ * handle_lwc1, handle_ldc1, handle_swc1, handle_sdc1
+ * Floating-point loads and stores of words and doublewords.
+ * Opcodes: 49, 53, 57, 61
+ */
+int handle_lwc1(uint32_t instr);
+int handle_ldc1(uint32_t instr);
+int handle_swc1(uint32_t instr);
+int handle_sdc1(uint32_t instr);
+
+/*
+ * fpu_restore
+ * Install saved FPU state. Used when switching between processes.
+ */
+void fpu_restore(const FPU_State *state);
+
+#endif // __FPU_H
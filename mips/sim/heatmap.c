@@ -0,0 +1,365 @@
+/*
+ * heatmap.c
+ * Guest memory access heatmap and working-set tracker.
+ *
+ * Loads and stores are counted per 64-byte line of each memory region.
+ * Each line also remembers the last window that touched it, so distinct
+ * lines and pages per window fall out of a compare, and the time of its
+ * last access, which a Fenwick tree over access times turns into an exact
+ * LRU stack (reuse) distance.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shell.h"
+#include "heatmap.h"
+
+int HEATMAP_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define LINES_PER_PAGE (HEAT_PAGE / HEAT_LINE)
+
+// access clock range before timestamps are compacted
+#define CLOCK_SIZE (1 << 20)
+
+// reuse distance buckets: 0, 1, 2-3, 4-7, ...
+#define REUSE_BUCKETS 20
+
+typedef struct {
+	uint32_t lines;
+	uint32_t *reads;        // per line
+	uint32_t *writes;
+	uint32_t *line_window;  // last window touching each line, plus one
+	uint32_t *page_window;  // last window touching each page, plus one
+	uint32_t *last;         // clock of the last access to each line, 0 = never
+} Segment;
+
+typedef struct {
+	uint32_t lines;
+	uint32_t pages;
+} Window;
+
+static Segment segments[MEM_NREGIONS];
+
+static uint64_t loads, stores, unmapped;
+
+// working set of the open window and of every closed one
+static uint32_t window_size, window_fill, window_index;
+static uint32_t window_lines, window_pages;
+static Window *windows;
+static uint32_t window_capacity;
+
+// Fenwick tree with a 1 at the last access time of every touched line
+static uint32_t *fenwick;
+static uint32_t clock_now = 1;
+
+static uint64_t reuse[REUSE_BUCKETS];
+static uint64_t cold;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static const char *region_name(uint32_t start) {
+	switch (start) {
+	case MEM_TEXT_START:  return "text";
+	case MEM_DATA_START:  return "data";
+	case MEM_STACK_START: return "stack";
+	case MEM_KDATA_START: return "kdata";
+	case MEM_KTEXT_START: return "ktext";
+	}
+	return "other";
+}
+
+static void fenwick_add(uint32_t i, int delta) {
+	for (; i < CLOCK_SIZE; i += i & -i) {
+		fenwick[i] += delta;
+	}
+}
+
+static uint32_t fenwick_sum(uint32_t i) {
+	uint32_t sum = 0;
+	for (; i > 0; i -= i & -i) {
+		sum += fenwick[i];
+	}
+	return sum;
+}
+
+typedef struct {
+	uint32_t time;
+	uint32_t *slot;
+} Stamp;
+
+static int compare_stamps(const void *a, const void *b) {
+	uint32_t ta = ((const Stamp *) a)->time, tb = ((const Stamp *) b)->time;
+	return (ta > tb) - (ta < tb);
+}
+
+/*
+ * compact_clock
+ * Renumber last access times 1..n keeping their order, once the clock
+ * runs out of range.
+ */
+static void compact_clock(void) {
+	uint32_t n = 0, total = 0;
+
+	for (int r = 0; r < MEM_NREGIONS; r++) {
+		total += segments[r].lines;
+	}
+
+	Stamp *stamps = malloc(total * sizeof(Stamp));
+	for (int r = 0; r < MEM_NREGIONS; r++) {
+		for (uint32_t line = 0; line < segments[r].lines; line++) {
+			if (segments[r].last[line]) {
+				stamps[n].time = segments[r].last[line];
+				stamps[n].slot = &segments[r].last[line];
+				n++;
+			}
+		}
+	}
+	qsort(stamps, n, sizeof(Stamp), compare_stamps);
+
+	memset(fenwick, 0, CLOCK_SIZE * sizeof(uint32_t));
+	for (uint32_t i = 0; i < n; i++) {
+		*stamps[i].slot = i + 1;
+		fenwick_add(i + 1, 1);
+	}
+	clock_now = n + 1;
+	free(stamps);
+}
+
+static void close_window(void) {
+	if (window_index == window_capacity) {
+		window_capacity = window_capacity ? window_capacity * 2 : 256;
+		windows = realloc(windows, window_capacity * sizeof(Window));
+	}
+	windows[window_index].lines = window_lines;
+	windows[window_index].pages = window_pages;
+	window_index++;
+	window_lines = window_pages = window_fill = 0;
+}
+
+// sort pages by descending accesses
+static const uint64_t *sort_counts;
+
+static int compare_pages(const void *a, const void *b) {
+	uint64_t ca = sort_counts[*(const uint32_t *) a];
+	uint64_t cb = sort_counts[*(const uint32_t *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Heatmap Interface
+	See module header file (heatmap.h) for detailed function comments.
+*/
+
+void heatmap_enable(uint32_t window) {
+	if (HEATMAP_ENABLED) {
+		return;
+	}
+
+	for (int r = 0; r < MEM_NREGIONS; r++) {
+		Segment *seg = &segments[r];
+		seg->lines = MEM_REGIONS[r].size / HEAT_LINE;
+		seg->reads = calloc(seg->lines, sizeof(uint32_t));
+		seg->writes = calloc(seg->lines, sizeof(uint32_t));
+		seg->line_window = calloc(seg->lines, sizeof(uint32_t));
+		seg->page_window = calloc(seg->lines / LINES_PER_PAGE, sizeof(uint32_t));
+		seg->last = calloc(seg->lines, sizeof(uint32_t));
+	}
+	fenwick = calloc(CLOCK_SIZE, sizeof(uint32_t));
+
+	window_size = window ? window : 1;
+	HEATMAP_ENABLED = 1;
+}
+
+void heatmap_access(uint32_t address, int store) {
+	Segment *seg = NULL;
+	uint32_t line = 0;
+
+	for (int r = 0; r < MEM_NREGIONS; r++) {
+		if (address >= MEM_REGIONS[r].start &&
+				address < MEM_REGIONS[r].start + MEM_REGIONS[r].size) {
+			seg = &segments[r];
+			line = (address - MEM_REGIONS[r].start) / HEAT_LINE;
+			break;
+		}
+	}
+	if (seg == NULL) {
+		unmapped++;
+		return;
+	}
+
+	if (store) {
+		stores++;
+		seg->writes[line]++;
+	} else {
+		loads++;
+		seg->reads[line]++;
+	}
+
+	// distinct lines and pages in the open window
+	if (seg->line_window[line] != window_index + 1) {
+		seg->line_window[line] = window_index + 1;
+		window_lines++;
+	}
+	if (seg->page_window[line / LINES_PER_PAGE] != window_index + 1) {
+		seg->page_window[line / LINES_PER_PAGE] = window_index + 1;
+		window_pages++;
+	}
+
+	// distinct lines touched since this line's previous access
+	if (clock_now == CLOCK_SIZE) {
+		compact_clock();
+	}
+	uint32_t previous = seg->last[line];
+	if (previous) {
+		uint32_t distance = fenwick_sum(clock_now - 1) - fenwick_sum(previous);
+		int bucket = 0;
+		while (distance && bucket < REUSE_BUCKETS - 1) {
+			distance >>= 1;
+			bucket++;
+		}
+		reuse[bucket]++;
+		fenwick_add(previous, -1);
+	} else {
+		cold++;
+	}
+	seg->last[line] = clock_now;
+	fenwick_add(clock_now, 1);
+	clock_now++;
+}
+
+void heatmap_tick(void) {
+	if (++window_fill == window_size) {
+		close_window();
+	}
+}
+
+void heatmap_report(FILE *out, int top_n) {
+	uint64_t accesses = loads + stores;
+
+	if (!HEATMAP_ENABLED) {
+		return;
+	}
+
+	fprintf(out, "\nMemory heatmap (%llu loads, %llu stores, %llu outside regions) :\n",
+		(unsigned long long) loads, (unsigned long long) stores,
+		(unsigned long long) unmapped);
+	fprintf(out, "-------------------------------------\n");
+
+	// working set, including the partial window at halt
+	uint32_t n = window_index + (window_fill > 0);
+	uint32_t min_lines = UINT32_MAX, max_lines = 0, max_pages = 0;
+	uint64_t sum_lines = 0, sum_pages = 0;
+	for (uint32_t w = 0; w < n; w++) {
+		Window win = w < window_index ? windows[w] :
+			(Window) { window_lines, window_pages };
+		min_lines = win.lines < min_lines ? win.lines : min_lines;
+		max_lines = win.lines > max_lines ? win.lines : max_lines;
+		max_pages = win.pages > max_pages ? win.pages : max_pages;
+		sum_lines += win.lines;
+		sum_pages += win.pages;
+	}
+	fprintf(out, "Working set per %u instructions (%u windows):\n", window_size, n);
+	if (n) {
+		fprintf(out, "  lines : min %u  avg %.1f  max %u  (max %u bytes)\n", min_lines,
+			(double) sum_lines / n, max_lines, max_lines * HEAT_LINE);
+		fprintf(out, "  pages : avg %.1f  max %u  (max %u bytes)\n",
+			(double) sum_pages / n, max_pages, max_pages * HEAT_PAGE);
+
+		// a timeline of at most 16 evenly spaced windows
+		uint32_t step = (n + 15) / 16;
+		for (uint32_t w = 0; w < n; w += step) {
+			Window win = w < window_index ? windows[w] :
+				(Window) { window_lines, window_pages };
+			fprintf(out, "  window %6u  %8u lines  %6u pages\n", w, win.lines, win.pages);
+		}
+	}
+
+	fprintf(out, "Reuse distance (distinct %d-byte lines between accesses):\n", HEAT_LINE);
+	fprintf(out, "  %-14s  %12llu  %6.2f%%\n", "cold", (unsigned long long) cold,
+		accesses ? 100.0 * cold / accesses : 0.0);
+	for (int b = 0; b < REUSE_BUCKETS; b++) {
+		char label[32];
+		if (reuse[b] == 0) {
+			continue;
+		}
+		if (b <= 1) {
+			snprintf(label, sizeof(label), "%d", b);
+		} else if (b == REUSE_BUCKETS - 1) {
+			snprintf(label, sizeof(label), ">= %u", 1U << (b - 1));
+		} else {
+			snprintf(label, sizeof(label), "%u-%u", 1U << (b - 1), (1U << b) - 1);
+		}
+		fprintf(out, "  %-14s  %12llu  %6.2f%%\n", label, (unsigned long long) reuse[b],
+			100.0 * reuse[b] / accesses);
+	}
+
+	fprintf(out, "Hottest pages by region:\n");
+	for (int r = 0; r < MEM_NREGIONS; r++) {
+		Segment *seg = &segments[r];
+		uint32_t pages = seg->lines / LINES_PER_PAGE, count = 0;
+		uint64_t *heat = calloc(pages, sizeof(uint64_t));
+		uint32_t *order = malloc(pages * sizeof(uint32_t));
+
+		for (uint32_t line = 0; line < seg->lines; line++) {
+			heat[line / LINES_PER_PAGE] += seg->reads[line] + seg->writes[line];
+		}
+		for (uint32_t page = 0; page < pages; page++) {
+			if (heat[page]) {
+				order[count++] = page;
+			}
+		}
+
+		if (count) {
+			sort_counts = heat;
+			qsort(order, count, sizeof(uint32_t), compare_pages);
+
+			fprintf(out, "  %s (%u pages touched):\n", region_name(MEM_REGIONS[r].start), count);
+			for (uint32_t i = 0; i < count && i < (uint32_t) top_n; i++) {
+				uint64_t reads = 0, writes = 0;
+				for (uint32_t line = order[i] * LINES_PER_PAGE;
+						line < (order[i] + 1) * LINES_PER_PAGE; line++) {
+					reads += seg->reads[line];
+					writes += seg->writes[line];
+				}
+				fprintf(out, "    0x%08x  %12llu reads  %12llu writes  %6.2f%%\n",
+					MEM_REGIONS[r].start + order[i] * HEAT_PAGE,
+					(unsigned long long) reads, (unsigned long long) writes,
+					100.0 * heat[order[i]] / accesses);
+			}
+		}
+		free(order);
+		free(heat);
+	}
+	fprintf(out, "\n");
+}
+
+int heatmap_export(const char *filename) {
+	FILE *out;
+
+	if (!HEATMAP_ENABLED || (out = fopen(filename, "w")) == NULL) {
+		return -1;
+	}
+
+	fprintf(out, "address,region,reads,writes\n");
+	for (int r = 0; r < MEM_NREGIONS; r++) {
+		Segment *seg = &segments[r];
+		for (uint32_t line = 0; line < seg->lines; line++) {
+			if (seg->reads[line] || seg->writes[line]) {
+				fprintf(out, "0x%08x,%s,%u,%u\n", MEM_REGIONS[r].start + line * HEAT_LINE,
+					region_name(MEM_REGIONS[r].start), seg->reads[line], seg->writes[line]);
+			}
+		}
+	}
+
+	fclose(out);
+	return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * heatmap.h
+ * Guest memory access heatmap and working-set tracker.
+ */
+
+#ifndef __HEATMAP_H
+#define __HEATMAP_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define HEAT_LINE 64     // bytes per tracked line
+#define HEAT_PAGE 4096   // bytes per tracked page
+
+// whether the tracker is on
+extern int HEATMAP_ENABLED;
+
+/*
+ * heatmap_enable
+ * Allocate per-line counters for every memory region and turn the tracker
+ * on. Working sets are measured over windows of window instructions.
+ */
+void heatmap_enable(uint32_t window);
+
+/*
+ * heatmap_access
+ * Count a load (store = 0) or store at address, updating its window stamp
+ * and reuse distance.
+ */
+void heatmap_access(uint32_t address, int store);
+
+/*
+ * heatmap_tick
+ * Advance by one retired instruction, closing the window when it is full.
+ */
+void heatmap_tick(void);
+
+/*
+ * heatmap_report
+ * Print access totals, working-set sizes per window, the reuse distance
+ * histogram and the top_n hottest pages of each memory region.
+ */
+void heatmap_report(FILE *out, int top_n);
+
+/*
+ * heatmap_export
+ * Write per-line read and write counts as CSV (address,region,reads,writes)
+ * for every line that was accessed. Returns 0 on success.
+ */
+int heatmap_export(const char *filename);
+
+#endif // __HEATMAP_H
@@ -0,0 +1,177 @@
+/*
+ * live.c
+ * Live run statistics published in a shared memory segment.
+ *
+ * Updates are scheduled every LIVE_INTERVAL instructions on the event
+ * scheduler, so they cost the run loop nothing in between. Instruction
+ * classes are summed from the instruction mix counters at each update.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "shell.h"
+#include "stats.h"
+#include "live.h"
+#include "events.h"
+
+int LIVE_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+static LiveStats *live;
+
+// previous update, for the instruction rate
+static double start_seconds, last_seconds;
+static uint64_t last_instructions;
+
+static TimedEvent publish_event;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static double now_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * classify
+ * Sum the instruction mix counters into instruction classes.
+ */
+static void classify(uint64_t *classes) {
+	memset(classes, 0, LIVE_CLASSES * sizeof(uint64_t));
+
+	for (int op = 0; op < DISPATCH_SIZE; op++) {
+		uint64_t count = STATS.opcode[op];
+		int class;
+
+		if (op == OPCODE_SPECIAL || op == OPCODE_REGIMM || count == 0) {
+			continue;
+		} else if (op == OPCODE_J || op == OPCODE_JAL) {
+			class = LIVE_JUMP;
+		} else if (op >= OPCODE_BEQ && op <= OPCODE_BGTZ) {
+			class = LIVE_BRANCH;
+		} else if ((op >= OPCODE_ADDI && op <= OPCODE_LUI) ||
+				op == OPCODE_SPECIAL2 || op == OPCODE_SPECIAL3) {
+			class = LIVE_ALU;
+		} else if ((op >= OPCODE_LB && op <= OPCODE_LHU) || op == OPCODE_LWC1 || op == OPCODE_LDC1) {
+			class = LIVE_LOAD;
+		} else if ((op >= OPCODE_SB && op <= OPCODE_SW) || op == OPCODE_SWC1 || op == OPCODE_SDC1) {
+			class = LIVE_STORE;
+		} else {
+			class = LIVE_OTHER;
+		}
+		classes[class] += count;
+	}
+
+	for (int func = 0; func < DISPATCH_SIZE; func++) {
+		uint64_t count = STATS.function[func];
+		int class;
+
+		if (count == 0) {
+			continue;
+		} else if (func == FUNC_JR || func == FUNC_JALR) {
+			class = LIVE_JUMP;
+		} else if (func == FUNC_SYSCALL) {
+			class = LIVE_SYSCALL;
+		} else if (func >= FUNC_MFHI && func <= FUNC_DIVU) {
+			class = LIVE_MULDIV;
+		} else if (func <= FUNC_SRAV || func == FUNC_MOVZ || func == FUNC_MOVN ||
+				(func >= FUNC_ADD && func <= FUNC_SLTU)) {
+			class = LIVE_ALU;
+		} else {
+			class = LIVE_OTHER;
+		}
+		classes[class] += count;
+	}
+
+	// every regimm instruction is a conditional branch
+	for (int target = 0; target < DISPATCH_SIZE; target++) {
+		classes[LIVE_BRANCH] += STATS.target[target];
+	}
+}
+
+static void publish_periodic(void *unused) {
+	live_publish();
+	event_schedule(&publish_event, LIVE_INTERVAL);
+}
+
+/* ----------------------------------------------------------------------------
+	Live Statistics Interface
+	See module header file (live.h) for detailed function comments.
+*/
+
+int live_enable(const char *name, const char *program) {
+	int fd;
+
+	shm_unlink(name);
+	if ((fd = shm_open(name, O_CREAT | O_RDWR, 0644)) < 0) {
+		return -1;
+	}
+	if (ftruncate(fd, sizeof(LiveStats)) != 0) {
+		close(fd);
+		return -1;
+	}
+	live = mmap(NULL, sizeof(LiveStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (live == MAP_FAILED) {
+		live = NULL;
+		return -1;
+	}
+
+	live->pid = getpid();
+	strncpy(live->program, program, sizeof(live->program) - 1);
+	live->version = LIVE_VERSION;
+
+	start_seconds = last_seconds = now_seconds();
+	LIVE_ENABLED = 1;
+
+	live_publish();
+	atomic_thread_fence(memory_order_release);
+	live->magic = LIVE_MAGIC;
+
+	event_init(&publish_event, publish_periodic, NULL);
+	event_schedule(&publish_event, LIVE_INTERVAL);
+	return 0;
+}
+
+void live_publish(void) {
+	uint64_t instructions = INSTRUCTION_COUNT;
+	double now = now_seconds();
+
+	uint32_t seq = atomic_load_explicit(&live->seq, memory_order_relaxed);
+	atomic_store_explicit(&live->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	live->instructions = instructions;
+	live->pc = CURRENT_STATE.PC;
+	live->halted = !RUN_BIT;
+	live->seconds = now - start_seconds;
+	if (now > last_seconds) {
+		live->ips = (instructions - last_instructions) / (now - last_seconds);
+	}
+	classify(live->classes);
+
+	atomic_store_explicit(&live->seq, seq + 2, memory_order_release);
+
+	last_seconds = now;
+	last_instructions = instructions;
+}
+
+void live_halt(void) {
+	event_cancel(&publish_event);
+	live_publish();
+	LIVE_ENABLED = 0;
+}
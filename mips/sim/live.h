@@ -0,0 +1,93 @@
+/*
+ * live.h
+ * Live run statistics published in a shared memory segment.
+ *
+ * The segment layout is shared with the simtop monitor. The simulator is the
+ * only writer and updates it under a sequence lock: seq is odd while an update
+ * is in progress, so a reader retries until it sees the same even value before
+ * and after copying the fields.
+ */
+
+#ifndef __LIVE_H
+#define __LIVE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define LIVE_MAGIC   0x4d495053  // "MIPS"
+#define LIVE_VERSION 1
+
+// instruction classes
+#define LIVE_ALU     0
+#define LIVE_LOAD    1
+#define LIVE_STORE   2
+#define LIVE_BRANCH  3
+#define LIVE_JUMP    4
+#define LIVE_MULDIV  5
+#define LIVE_SYSCALL 6
+#define LIVE_OTHER   7
+#define LIVE_CLASSES 8
+
+// instructions between updates
+#define LIVE_INTERVAL (1 << 16)
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	_Atomic uint32_t seq;
+	uint32_t pid;
+	char program[64];
+
+	uint64_t instructions;           // retired instructions
+	uint32_t pc;                     // current PC
+	uint32_t halted;                 // set once the program halts
+	double seconds;                  // host seconds since the run started
+	double ips;                      // instructions per second since the last update
+	uint64_t classes[LIVE_CLASSES];  // retired instructions by class
+} LiveStats;
+
+/*
+ * live_read
+ * Take a consistent snapshot of a segment. Returns 0 on success, -1 if the
+ * writer kept it busy.
+ */
+static inline int live_read(const LiveStats *live, LiveStats *snapshot) {
+	for (int tries = 0; tries < 1000; tries++) {
+		uint32_t seq = atomic_load_explicit(&live->seq, memory_order_acquire);
+		if (seq & 1) {
+			continue;
+		}
+
+		*snapshot = *live;
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&live->seq, memory_order_relaxed) == seq) {
+			return 0;
+		}
+	}
+	return -1;
+}
+
+// whether statistics are being published
+extern int LIVE_ENABLED;
+
+/*
+ * live_enable
+ * Create (or replace) the shared memory segment name and start publishing.
+ * Returns 0 on success.
+ */
+int live_enable(const char *name, const char *program);
+
+/*
+ * live_publish
+ * Update the segment from the current machine state and counters.
+ */
+void live_publish(void);
+
+/*
+ * live_halt
+ * Publish the final state and mark the run halted. The segment is left in
+ * place so a monitor can see how the run ended.
+ */
+void live_halt(void);
+
+#endif // __LIVE_H
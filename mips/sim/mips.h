@@ -11,8 +11,39 @@
 */
 
 #define REG_SYSCALL  2
+#define REG_RESULT   2
+#define REG_ARG0     4
+#define REG_ARG1     5
+#define REG_ARG2     6
 #define REG_LINK    31
 
+#define FREG_RESULT  0
+#define FREG_ARG0   12
+
+/* ----------------------------------------------------------------------------
+	System Call Codes (in REG_SYSCALL)
+*/
+
+#define SYSCALL_PRINT_INT     1   // print $a0 as a signed integer
+#define SYSCALL_PRINT_FLOAT   2   // print $f12
+#define SYSCALL_PRINT_DOUBLE  3   // print $f12/$f13
+#define SYSCALL_PRINT_STRING  4   // print the string at $a0
+#define SYSCALL_READ_INT      5   // read an integer line into $v0
+#define SYSCALL_READ_FLOAT    6   // read a float line into $f0
+#define SYSCALL_READ_DOUBLE   7   // read a double line into $f0/$f1
+#define SYSCALL_READ_STRING   8   // read up to $a1 - 1 chars into the buffer at $a0
+#define SYSCALL_SBRK          9   // grow the heap by $a0 bytes, old break in $v0
+#define SYSCALL_EXIT         10
+#define SYSCALL_PRINT_CHAR   11   // print the low byte of $a0
+#define SYSCALL_READ_CHAR    12   // read a char into $v0
+#define SYSCALL_OPEN         13   // open file $a0 with flags $a1, descriptor in $v0
+#define SYSCALL_READ         14   // read $a2 bytes from $a0 into $a1, count in $v0
+#define SYSCALL_WRITE        15   // write $a2 bytes at $a1 to $a0, count in $v0
+#define SYSCALL_CLOSE        16   // close descriptor $a0
+#define SYSCALL_EXIT2        17   // exit with code $a0
+#define SYSCALL_PHASE_BEGIN 100   // trace marker: phase $a0 begins
+#define SYSCALL_PHASE_END   101   // trace marker: phase $a0 ends
+
 /* ----------------------------------------------------------------------------
 	Instruction Opcodes 
 */
@@ -33,6 +64,10 @@
 #define OPCODE_ORI    13
 #define OPCODE_XORI   14
 #define OPCODE_LUI    15
+#define OPCODE_COP0   16
+#define OPCODE_COP1   17
+#define OPCODE_SPECIAL2 28
+#define OPCODE_SPECIAL3 31
 #define OPCODE_LB     32
 #define OPCODE_LH     33
 #define OPCODE_LW     35
@@ -41,6 +76,10 @@
 #define OPCODE_SB     40
 #define OPCODE_SH     41
 #define OPCODE_SW     43
+#define OPCODE_LWC1   49
+#define OPCODE_LDC1   53
+#define OPCODE_SWC1   57
+#define OPCODE_SDC1   61
 
 /* ----------------------------------------------------------------------------
 	Instruction Function Codes  
@@ -54,6 +93,8 @@
 #define FUNC_SRAV     7
 #define FUNC_JR       8
 #define FUNC_JALR     9
+#define FUNC_MOVZ    10
+#define FUNC_MOVN    11
 #define FUNC_SYSCALL 12
 #define FUNC_MFHI    16
 #define FUNC_MTHI    17
@@ -74,6 +115,85 @@
 #define FUNC_SLT     42
 #define FUNC_SLTU    43
 
+// rotr and rotrv are srl and srlv with this bit set in rs and shamt
+#define FUNC_ROTATE   1
+
+/* ----------------------------------------------------------------------------
+	Instruction Function Codes, SPECIAL2 and SPECIAL3 (MIPS32 Release 2)
+*/
+
+#define FUNC2_MUL     2
+#define FUNC2_CLZ    32
+#define FUNC2_CLO    33
+
+#define FUNC3_EXT     0
+#define FUNC3_INS     4
+#define FUNC3_BSHFL  32
+#define FUNC3_RDHWR  59
+
+// bshfl operations, in the shamt field
+#define BSHFL_WSBH    2
+#define BSHFL_SEB    16
+#define BSHFL_SEH    24
+
+// hardware registers readable by rdhwr, in the rd field
+#define HWR_CPUNUM      0
+#define HWR_SYNCI_STEP  1
+#define HWR_CC          2   // cycle counter
+#define HWR_CCRES       3   // cycles per HWR_CC increment
+
+/* ----------------------------------------------------------------------------
+	Coprocessor 0 (System Control) Codes
+*/
+
+// operation, in the rs field
+#define COP0_MF       0
+#define COP0_MT       4
+#define COP0_CO      16   // function field holds the operation
+
+#define FUNC_CO_TLBR   1
+#define FUNC_CO_TLBWI  2
+#define FUNC_CO_TLBWR  6
+#define FUNC_CO_TLBP   8
+#define FUNC_CO_ERET  24
+
+/* ----------------------------------------------------------------------------
+	Coprocessor 1 (Floating Point) Codes
+*/
+
+// operation or operand format, in the rs field
+#define COP1_MF       0
+#define COP1_CF       2
+#define COP1_MT       4
+#define COP1_CT       6
+#define COP1_BC       8
+#define COP1_FMT_S   16
+#define COP1_FMT_D   17
+#define COP1_FMT_W   20
+
+// arithmetic function codes
+#define FUNC_FP_ADD      0
+#define FUNC_FP_SUB      1
+#define FUNC_FP_MUL      2
+#define FUNC_FP_DIV      3
+#define FUNC_FP_SQRT     4
+#define FUNC_FP_ABS      5
+#define FUNC_FP_MOV      6
+#define FUNC_FP_NEG      7
+#define FUNC_FP_ROUND_W 12
+#define FUNC_FP_TRUNC_W 13
+#define FUNC_FP_CEIL_W  14
+#define FUNC_FP_FLOOR_W 15
+#define FUNC_FP_CVT_S   32
+#define FUNC_FP_CVT_D   33
+#define FUNC_FP_CVT_W   36
+#define FUNC_FP_C       48   // c.cond: 48 + condition
+
+// control registers
+#define FCR_FIR   0
+#define FCR_FCCR 25
+#define FCR_FCSR 31
+
 /* ----------------------------------------------------------------------------
 	Instruction Target Codes
 */
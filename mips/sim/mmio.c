@@ -0,0 +1,82 @@
+/*
+ * mmio.c
+ * Memory-mapped device registers.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "shell.h"
+#include "mmio.h"
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define MAX_DEVICES 16
+
+typedef struct {
+	uint32_t base;
+	uint32_t size;
+	MmioRead read;
+	MmioWrite write;
+	void *device;
+} Mapping;
+
+static Mapping mappings[MAX_DEVICES];
+static int mapping_count;
+
+/*
+ * find
+ * Device mapped at address, or NULL.
+ */
+static Mapping *find(uint32_t address) {
+	for (int i = 0; i < mapping_count; i++) {
+		if (address - mappings[i].base < mappings[i].size) {
+			return &mappings[i];
+		}
+	}
+	return NULL;
+}
+
+/* ----------------------------------------------------------------------------
+	MMIO Interface
+	See module header file (mmio.h) for detailed function comments.
+*/
+
+int mmio_register(uint32_t base, uint32_t size, MmioRead read, MmioWrite write, void *device) {
+	if (mapping_count == MAX_DEVICES || size == 0) {
+		return -1;
+	}
+
+	// devices can't share a page with RAM
+	for (uint32_t page = base >> PAGE_BITS; page <= (base + size - 1) >> PAGE_BITS; page++) {
+		if (MEM_PAGES[page].attr & PAGE_READ) {
+			return -1;
+		}
+	}
+
+	mappings[mapping_count++] = (Mapping) { base, size, read, write, device };
+	mem_map_device(base, size);
+	return 0;
+}
+
+uint32_t mmio_read(uint32_t address) {
+	Mapping *mapping = find(address);
+
+	if (mapping == NULL || mapping->read == NULL) {
+		return 0;
+	}
+
+	// byte and halfword loads take the low bits, so move their lane down
+	uint32_t offset = address - mapping->base;
+	return mapping->read(mapping->device, offset & ~3) >> ((offset & 3) * 8);
+}
+
+void mmio_write(uint32_t address, uint32_t value) {
+	Mapping *mapping = find(address);
+
+	if (mapping != NULL && mapping->write != NULL) {
+		mapping->write(mapping->device, address - mapping->base, value);
+	}
+}
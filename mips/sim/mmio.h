@@ -0,0 +1,44 @@
+/*
+ * mmio.h
+ * Memory-mapped device registers.
+ *
+ * A device claims a range of guest addresses. The pages covering it are
+ * marked PAGE_MMIO in the page table, so only accesses to those pages leave
+ * the RAM fast path in mem_read_32 and mem_write_32. Device registers are
+ * word-sized and word-aligned. Byte and halfword loads read the whole
+ * register and take their lane of it. Byte and halfword stores go to the
+ * device as they are, never reading the register to merge bytes: the
+ * device gets the store's byte offset and the zero-extended value, so a
+ * store to the low byte of a register writes it, and a store to any other
+ * byte matches no register and is ignored.
+ */
+
+#ifndef __MMIO_H
+#define __MMIO_H
+
+#include <stdint.h>
+
+// register reads, with the offset of the word from the device base, and
+// writes, with the offset of the store (word-aligned for sw)
+typedef uint32_t (*MmioRead)(void *device, uint32_t offset);
+typedef void (*MmioWrite)(void *device, uint32_t offset, uint32_t value);
+
+/*
+ * mmio_register
+ * Map a device's registers at [base, base + size). Either callback may be
+ * NULL: reads then return 0 and writes are ignored. Returns 0 on success,
+ * -1 if the device table is full or the range overlaps RAM.
+ */
+int mmio_register(uint32_t base, uint32_t size, MmioRead read, MmioWrite write, void *device);
+
+/*
+ * mmio_read, mmio_write
+ * Access the device register at address, which lies on a PAGE_MMIO page.
+ * mmio_read returns the register shifted right by the byte lane of
+ * address; mmio_write passes value on as it is. Addresses on the page that
+ * belong to no device read as 0.
+ */
+uint32_t mmio_read(uint32_t address);
+void mmio_write(uint32_t address, uint32_t value);
+
+#endif // __MMIO_H
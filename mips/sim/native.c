@@ -0,0 +1,183 @@
+/*
+ * native.c
+ * Host-native implementations of recognized guest library routines.
+ *
+ * A call to a bound routine retires as the single jal/jalr and returns to the
+ * instruction after it. Memory and $v0 end up exactly as the guest routine
+ * would leave them; caller-saved temporaries it would have clobbered are left
+ * alone, and its loads and stores are not seen by the analysis models.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "shell.h"
+#include "tlb.h"
+#include "native.h"
+
+int NATIVE_ROUTINES;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define MAX_ROUTINES 16
+
+typedef int (*Routine)(uint32_t a0, uint32_t a1, uint32_t a2, uint32_t *result);
+
+typedef struct {
+	uint32_t entry;
+	int kind;
+	uint64_t calls;
+	uint64_t bytes;
+} Binding;
+
+static Binding bindings[MAX_ROUTINES];
+
+// bytes handled by the last routine run, for the report
+static uint32_t handled;
+
+/* ----------------------------------------------------------------------------
+	Routines
+*/
+
+static int native_memcpy(uint32_t dst, uint32_t src, uint32_t n, uint32_t *result) {
+	uint32_t dst_available, src_available;
+	uint8_t *to = tlb_span(dst, &dst_available, 1);
+	uint8_t *from = tlb_span(src, &src_available, 0);
+
+	if (to == NULL || from == NULL || n > dst_available || n > src_available) {
+		return 0;
+	}
+
+	if (to > from && to < from + n) {
+		// a forward byte loop replicates the overlapping prefix
+		for (uint32_t i = 0; i < n; i++) {
+			to[i] = from[i];
+		}
+	} else {
+		memmove(to, from, n);
+	}
+
+	handled = n;
+	*result = dst;
+	return 1;
+}
+
+static int native_memset(uint32_t dst, uint32_t value, uint32_t n, uint32_t *result) {
+	uint32_t available;
+	uint8_t *to = tlb_span(dst, &available, 1);
+
+	if (to == NULL || n > available) {
+		return 0;
+	}
+
+	memset(to, value & 0xFF, n);
+
+	handled = n;
+	*result = dst;
+	return 1;
+}
+
+static int native_strlen(uint32_t string, uint32_t unused1, uint32_t unused2, uint32_t *result) {
+	uint32_t available;
+	uint8_t *from = tlb_span(string, &available, 0);
+	uint32_t length;
+
+	// the string must end inside its region, or its page with the TLB on
+	if (from == NULL || (length = strnlen((const char *) from, available)) == available) {
+		return 0;
+	}
+
+	handled = length;
+	*result = length;
+	return 1;
+}
+
+static const struct {
+	const char *name;
+	Routine routine;
+} ROUTINES[] = {
+	{ "memcpy", native_memcpy },
+	{ "memset", native_memset },
+	{ "strlen", native_strlen },
+};
+
+#define ROUTINE_KINDS ((int) (sizeof(ROUTINES) / sizeof(ROUTINES[0])))
+
+/* ----------------------------------------------------------------------------
+	Native Routine Interface
+	See module header file (native.h) for detailed function comments.
+*/
+
+int native_load(const char *filename) {
+	char line[256], name[128], type[16];
+	unsigned int entry;
+	FILE *map;
+
+	if ((map = fopen(filename, "r")) == NULL) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), map) != NULL && NATIVE_ROUTINES < MAX_ROUTINES) {
+		// "address name" or nm's "address type name"
+		if (sscanf(line, "%x %15s %127s", &entry, type, name) != 3 &&
+				sscanf(line, "%x %127s", &entry, name) != 2) {
+			continue;
+		}
+
+		for (int kind = 0; kind < ROUTINE_KINDS; kind++) {
+			if (strcmp(name, ROUTINES[kind].name) == 0) {
+				bindings[NATIVE_ROUTINES].entry = entry;
+				bindings[NATIVE_ROUTINES].kind = kind;
+				NATIVE_ROUTINES++;
+				break;
+			}
+		}
+	}
+
+	fclose(map);
+	return NATIVE_ROUTINES;
+}
+
+int native_call(uint32_t entry) {
+	for (int i = 0; i < NATIVE_ROUTINES; i++) {
+		Binding *binding = &bindings[i];
+		uint32_t result;
+
+		if (binding->entry != entry) {
+			continue;
+		}
+
+		if (!ROUTINES[binding->kind].routine(CURRENT_STATE.REGS[REG_ARG0],
+				CURRENT_STATE.REGS[REG_ARG1], CURRENT_STATE.REGS[REG_ARG2], &result)) {
+			return 0;
+		}
+
+		NEXT_STATE.REGS[REG_RESULT] = result;
+		binding->calls++;
+		binding->bytes += handled;
+		return 1;
+	}
+	return 0;
+}
+
+void native_report(FILE *out) {
+	if (!NATIVE_ROUTINES) {
+		return;
+	}
+
+	fprintf(out, "\nNative routines :\n");
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  %-10s  %-10s  %12s  %14s\n", "routine", "entry", "calls", "bytes");
+	for (int i = 0; i < NATIVE_ROUTINES; i++) {
+		Binding *binding = &bindings[i];
+		fprintf(out, "  %-10s  0x%08x  %12llu  %14llu\n", ROUTINES[binding->kind].name,
+			binding->entry, (unsigned long long) binding->calls,
+			(unsigned long long) binding->bytes);
+	}
+	fprintf(out, "\n");
+}
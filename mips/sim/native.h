@@ -0,0 +1,38 @@
+/*
+ * native.h
+ * Host-native implementations of recognized guest library routines.
+ */
+
+#ifndef __NATIVE_H
+#define __NATIVE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// number of guest routines bound to native implementations
+extern int NATIVE_ROUTINES;
+
+/*
+ * native_load
+ * Read a symbol map (lines of "address name" or nm's "address type name")
+ * and bind every recognized routine (memcpy, memset, strlen) at its entry
+ * address. Returns the number bound, or -1 if the file can't be read.
+ */
+int native_load(const char *filename);
+
+/*
+ * native_call
+ * If entry is a bound routine, run it on guest memory with the arguments in
+ * CURRENT_STATE and leave its result in NEXT_STATE. Returns 1 if the call
+ * was handled, 0 if the guest code must run instead (no routine at entry,
+ * or arguments outside a single writable region).
+ */
+int native_call(uint32_t entry);
+
+/*
+ * native_report
+ * Print calls and bytes handled by each bound routine.
+ */
+void native_report(FILE *out);
+
+#endif // __NATIVE_H
@@ -0,0 +1,139 @@
+/*
+ * profile.c
+ * PC-level hot-spot profiler.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "shell.h"
+#include "disasm.h"
+#include "profile.h"
+
+uint64_t *PC_COUNTS = NULL;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+/*
+ * profile_extent
+ * Number of slots up to and including the last executed instruction,
+ * and total executions.
+ */
+static uint32_t profile_extent(uint64_t *total) {
+	uint32_t last = 0;
+
+	*total = 0;
+	for (uint32_t slot = 0; slot < PROFILE_SLOTS; slot++) {
+		if (PC_COUNTS[slot]) {
+			*total += PC_COUNTS[slot];
+			last = slot + 1;
+		}
+	}
+
+	return last;
+}
+
+// sort slots by descending count
+static int compare_slots(const void *a, const void *b) {
+	uint64_t ca = PC_COUNTS[*(const uint32_t *) a];
+	uint64_t cb = PC_COUNTS[*(const uint32_t *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Profiler Interface
+	See module header file (profile.h) for detailed function comments.
+*/
+
+void profile_enable(void) {
+	if (PC_COUNTS == NULL) {
+		PC_COUNTS = calloc(PROFILE_SLOTS, sizeof(uint64_t));
+	}
+}
+
+void profile_report(FILE *out, int top_n) {
+	uint64_t total;
+	char text[64];
+
+	if (PC_COUNTS == NULL) {
+		return;
+	}
+
+	uint32_t extent = profile_extent(&total);
+
+	// rank executed slots by count
+	uint32_t *slots = malloc(sizeof(uint32_t) * (extent ? extent : 1));
+	uint32_t n = 0;
+	for (uint32_t slot = 0; slot < extent; slot++) {
+		if (PC_COUNTS[slot]) {
+			slots[n++] = slot;
+		}
+	}
+	qsort(slots, n, sizeof(uint32_t), compare_slots);
+
+	uint32_t listed = n < (uint32_t) top_n ? n : (uint32_t) top_n;
+	fprintf(out, "\nFlat profile (top %u of %u PCs, %llu instructions) :\n", listed, n,
+		(unsigned long long) total);
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  %-10s  %12s  %6s  %6s  %s\n", "PC", "count", "%", "cum%", "instruction");
+
+	uint64_t cumulative = 0;
+	for (uint32_t i = 0; i < listed; i++) {
+		uint32_t pc = MEM_TEXT_START + (slots[i] << 2);
+		cumulative += PC_COUNTS[slots[i]];
+		disasm(mem_read_32(pc), pc, text, sizeof(text));
+		fprintf(out, "  0x%08x  %12llu  %6.2f  %6.2f  %s\n", pc,
+			(unsigned long long) PC_COUNTS[slots[i]],
+			100.0 * PC_COUNTS[slots[i]] / total, 100.0 * cumulative / total, text);
+	}
+	free(slots);
+
+	fprintf(out, "\nAnnotated listing :\n");
+	fprintf(out, "-------------------------------------\n");
+	for (uint32_t slot = 0; slot < extent; slot++) {
+		uint32_t pc = MEM_TEXT_START + (slot << 2);
+		uint32_t instr = mem_read_32(pc);
+		disasm(instr, pc, text, sizeof(text));
+
+		if (PC_COUNTS[slot]) {
+			fprintf(out, "  %12llu  0x%08x: %08x  %s\n",
+				(unsigned long long) PC_COUNTS[slot], pc, instr, text);
+		} else {
+			fprintf(out, "  %12s  0x%08x: %08x  %s\n", ".", pc, instr, text);
+		}
+	}
+	fprintf(out, "\n");
+}
+
+int profile_callgrind(const char *filename, const char *program) {
+	uint64_t total;
+	FILE *out;
+
+	if (PC_COUNTS == NULL || (out = fopen(filename, "w")) == NULL) {
+		return -1;
+	}
+
+	uint32_t extent = profile_extent(&total);
+
+	fprintf(out, "# callgrind format\n");
+	fprintf(out, "version: 1\n");
+	fprintf(out, "creator: mips-sim\n");
+	fprintf(out, "positions: instr\n");
+	fprintf(out, "events: Ir\n");
+	fprintf(out, "summary: %llu\n\n", (unsigned long long) total);
+	fprintf(out, "ob=%s\n", program);
+	fprintf(out, "fn=0x%08x\n", MEM_TEXT_START);
+
+	for (uint32_t slot = 0; slot < extent; slot++) {
+		if (PC_COUNTS[slot]) {
+			fprintf(out, "0x%08x %llu\n", MEM_TEXT_START + (slot << 2),
+				(unsigned long long) PC_COUNTS[slot]);
+		}
+	}
+
+	fclose(out);
+	return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * profile.h
+ * PC-level hot-spot profiler.
+ */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "shell.h"
+
+// one counter per instruction slot of the text segment
+#define PROFILE_SLOTS (MEM_TEXT_SIZE >> 2)
+
+// execution counts indexed by (PC - MEM_TEXT_START) >> 2, NULL when disabled
+extern uint64_t *PC_COUNTS;
+
+// count one execution of the instruction at pc
+#define PROFILE_COUNT(pc) do {                                          \
+		uint32_t slot = ((pc) - MEM_TEXT_START) >> 2;                   \
+		if (PC_COUNTS && slot < PROFILE_SLOTS) PC_COUNTS[slot]++;       \
+	} while (0)
+
+/*
+ * profile_enable
+ * Allocate the counter array, turning the profiler on.
+ */
+void profile_enable(void);
+
+/*
+ * profile_report
+ * Print the top_n hottest PCs with counts and percentages, followed by an
+ * annotated disassembly listing of the executed part of the text segment.
+ */
+void profile_report(FILE *out, int top_n);
+
+/*
+ * profile_callgrind
+ * Write the profile in callgrind format (positions are instruction
+ * addresses, event is Ir). Returns 0 on success.
+ */
+int profile_callgrind(const char *filename, const char *program);
+
+#endif // __PROFILE_H
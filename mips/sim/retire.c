@@ -0,0 +1,273 @@
+/*
+ * retire.c
+ * Retired instruction records and the analysis consumers fed from them.
+ *
+ * Handlers note memory addresses and control flow outcomes in
+ * RETIRE_RECORD; once the instruction completes the record goes to each
+ * enabled consumer. In decoupled mode every consumer owns a thread and a
+ * lock-free single-producer single-consumer ring. The producer publishes
+ * its head every RING_BATCH records and only reads the consumer's tail when
+ * the ring looks full, so the functional core rarely touches a shared line.
+ * Consumers that depend on each other (the timing model reads the branch
+ * predictor's verdict) share a thread to keep their order.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "mips.h"
+#include "decode.h"
+#include "profile.h"
+#include "cache.h"
+#include "bpred.h"
+#include "timing.h"
+#include "callgraph.h"
+#include "heatmap.h"
+#include "retire.h"
+
+Record RETIRE_RECORD;
+int RETIRE_CONSUMERS;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define RING_SIZE  (1 << 16)   // records, a power of two
+#define RING_BATCH 64          // records between head/tail publications
+#define MAX_CONSUMERS 5
+
+typedef void (*consumer_t)(const Record *record);
+
+typedef struct {
+	Record records[RING_SIZE];
+
+	// written by the producer, read by the consumer
+	_Alignas(64) _Atomic uint64_t head;
+
+	// private to the producer
+	_Alignas(64) uint64_t local_head;
+	uint64_t cached_tail;
+
+	// written by the consumer, read by the producer
+	_Alignas(64) _Atomic uint64_t tail;
+
+	consumer_t consume;
+	pthread_t thread;
+} Ring;
+
+static consumer_t consumers[MAX_CONSUMERS];
+static Ring rings[MAX_CONSUMERS];
+static int decoupled;
+static _Atomic int stopping;  // consumers return once their ring is empty
+
+/* ----------------------------------------------------------------------------
+	Consumers
+*/
+
+static void consume_profile(const Record *record) {
+	PROFILE_COUNT(record->pc);
+}
+
+static void consume_callgraph(const Record *record) {
+	callgraph_retire(record->pc, record->next_pc, record->flags);
+}
+
+static void consume_heatmap(const Record *record) {
+	if (record->flags & RECORD_MEM) {
+		heatmap_access(record->mem_addr, (record->flags & RECORD_STORE) != 0);
+	}
+	heatmap_tick();
+}
+
+static void consume_cache(const Record *record) {
+	if (ICACHE.enabled) {
+		cache_access(&ICACHE, record->pc, record->pc);
+	}
+	if (DCACHE.enabled && (record->flags & RECORD_MEM)) {
+		cache_access(&DCACHE, record->mem_addr, record->pc);
+	}
+}
+
+static void consume_branch(const Record *record) {
+	if (BPRED_MODELS) {
+		if (record->flags & RECORD_BRANCH) {
+			int32_t offset = (int32_t) (decode_i_immediate(record->instr) << 2);
+			bpred_branch(record->pc, record->pc + offset, (record->flags & RECORD_TAKEN) != 0);
+		}
+		if (record->flags & RECORD_CALL) {
+			bpred_call(record->pc + 4);
+		}
+		if (record->flags & RECORD_RETURN) {
+			bpred_return(record->pc, record->next_pc);
+		}
+	}
+
+	if (TIMING.enabled) {
+		timing_retire(record->pc, record->instr, record->next_pc);
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Rings
+*/
+
+// spin briefly, then yield, then sleep while waiting on the other side
+static void backoff(int *idle) {
+	if (*idle < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	} else if (*idle < 1024) {
+		sched_yield();
+	} else {
+		struct timespec nap = { 0, 50000 };
+		nanosleep(&nap, NULL);
+	}
+	(*idle)++;
+}
+
+static void *ring_consumer(void *arg) {
+	Ring *ring = arg;
+	uint64_t tail = 0;
+	int idle = 0;
+
+	for (;;) {
+		uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+		if (head == tail) {
+			if (atomic_load_explicit(&stopping, memory_order_acquire)) {
+				break;
+			}
+			backoff(&idle);
+			continue;
+		}
+		idle = 0;
+
+		while (tail != head) {
+			ring->consume(&ring->records[tail & (RING_SIZE - 1)]);
+			tail++;
+			if ((tail & (RING_BATCH - 1)) == 0) {
+				atomic_store_explicit(&ring->tail, tail, memory_order_release);
+			}
+		}
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+	}
+
+	return NULL;
+}
+
+static void ring_push(Ring *ring, const Record *record) {
+	uint64_t head = ring->local_head;
+
+	if (head - ring->cached_tail == RING_SIZE) {
+		// full: publish everything and wait for the consumer to catch up
+		int idle = 0;
+		atomic_store_explicit(&ring->head, head, memory_order_release);
+		while (head - (ring->cached_tail = atomic_load_explicit(&ring->tail,
+				memory_order_acquire)) == RING_SIZE) {
+			backoff(&idle);
+		}
+	}
+
+	ring->records[head & (RING_SIZE - 1)] = *record;
+	ring->local_head = ++head;
+
+	if ((head & (RING_BATCH - 1)) == 0) {
+		atomic_store_explicit(&ring->head, head, memory_order_release);
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Retire Interface
+	See module header file (retire.h) for detailed function comments.
+*/
+
+void retire_start(int decouple) {
+	RETIRE_CONSUMERS = 0;
+
+	if (PC_COUNTS) {
+		consumers[RETIRE_CONSUMERS++] = consume_profile;
+	}
+	if (CALLGRAPH_ENABLED) {
+		consumers[RETIRE_CONSUMERS++] = consume_callgraph;
+	}
+	if (HEATMAP_ENABLED) {
+		consumers[RETIRE_CONSUMERS++] = consume_heatmap;
+	}
+	if (ICACHE.enabled || DCACHE.enabled) {
+		consumers[RETIRE_CONSUMERS++] = consume_cache;
+	}
+	if (BPRED_MODELS || TIMING.enabled) {
+		consumers[RETIRE_CONSUMERS++] = consume_branch;
+	}
+
+	decoupled = decouple && RETIRE_CONSUMERS;
+	if (!decoupled) {
+		return;
+	}
+
+	// keep the sampling profiler's SIGPROF on the functional core
+	sigset_t block, saved;
+	sigemptyset(&block);
+	sigaddset(&block, SIGPROF);
+	pthread_sigmask(SIG_BLOCK, &block, &saved);
+
+	int started;
+	for (started = 0; started < RETIRE_CONSUMERS; started++) {
+		rings[started].consume = consumers[started];
+		if (pthread_create(&rings[started].thread, NULL, ring_consumer, &rings[started]) != 0) {
+			break;
+		}
+	}
+
+	if (started < RETIRE_CONSUMERS) {
+		// nothing has been pushed yet, so the threads already started stop at once
+		fprintf(stderr, "Error: Can't start analysis thread, running inline\n");
+		atomic_store_explicit(&stopping, 1, memory_order_release);
+		for (int i = 0; i < started; i++) {
+			pthread_join(rings[i].thread, NULL);
+		}
+		decoupled = 0;
+	} else {
+		for (int i = 0; i < RETIRE_CONSUMERS; i++) {
+			pthread_detach(rings[i].thread);
+		}
+	}
+
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+}
+
+void retire(void) {
+	if (decoupled) {
+		for (int i = 0; i < RETIRE_CONSUMERS; i++) {
+			ring_push(&rings[i], &RETIRE_RECORD);
+		}
+	} else {
+		for (int i = 0; i < RETIRE_CONSUMERS; i++) {
+			consumers[i](&RETIRE_RECORD);
+		}
+	}
+}
+
+void retire_drain(void) {
+	if (!decoupled) {
+		return;
+	}
+
+	for (int i = 0; i < RETIRE_CONSUMERS; i++) {
+		Ring *ring = &rings[i];
+		int idle = 0;
+
+		atomic_store_explicit(&ring->head, ring->local_head, memory_order_release);
+		while (atomic_load_explicit(&ring->tail, memory_order_acquire) != ring->local_head) {
+			backoff(&idle);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/*
+ * retire.h
+ * Retired instruction records and the analysis consumers fed from them.
+ */
+
+#ifndef __RETIRE_H
+#define __RETIRE_H
+
+#include <stdint.h>
+
+// record flags
+#define RECORD_MEM     0x01   // load or store, mem_addr is valid
+#define RECORD_BRANCH  0x02   // conditional branch
+#define RECORD_TAKEN   0x04   // conditional branch was taken
+#define RECORD_CALL    0x08   // subroutine call, returns to pc + 4
+#define RECORD_RETURN  0x10   // jr $ra
+#define RECORD_STORE   0x20   // the memory access is a store
+
+typedef struct Record_Struct {
+	uint32_t pc;
+	uint32_t instr;
+	uint32_t next_pc;
+	uint32_t mem_addr;
+	uint32_t flags;
+} Record;
+
+// record of the instruction being executed, filled in by the handlers
+extern Record RETIRE_RECORD;
+
+// number of active analysis consumers, 0 when no analysis is enabled
+extern int RETIRE_CONSUMERS;
+
+// note a memory access by the executing instruction
+#define RETIRE_MEM(address) do {                                        \
+		RETIRE_RECORD.mem_addr = (address);                             \
+		RETIRE_RECORD.flags |= RECORD_MEM;                              \
+	} while (0)
+
+// note a store by the executing instruction
+#define RETIRE_STORE(address) do {                                      \
+		RETIRE_RECORD.mem_addr = (address);                             \
+		RETIRE_RECORD.flags |= RECORD_MEM | RECORD_STORE;               \
+	} while (0)
+
+// note a control flow event (RECORD_BRANCH, RECORD_CALL, ...)
+#define RETIRE_FLAG(flag) (RETIRE_RECORD.flags |= (flag))
+
+/*
+ * retire_start
+ * Set up a consumer for each enabled analysis (PC profile, call graph,
+ * memory heatmap, caches, branch prediction and pipeline timing). With
+ * decoupled set, each consumer runs on its own thread fed through a
+ * single-producer single-consumer ring; otherwise consumers run inline as
+ * each instruction retires.
+ */
+void retire_start(int decoupled);
+
+/*
+ * retire
+ * Hand the completed RETIRE_RECORD to every consumer.
+ */
+void retire(void);
+
+/*
+ * retire_drain
+ * Wait until every consumer has processed every record retired so far, so
+ * analysis results can be read.
+ */
+void retire_drain(void);
+
+#endif // __RETIRE_H
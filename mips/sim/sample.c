@@ -0,0 +1,185 @@
+/*
+ * sample.c
+ * Statistical sampling profiler driven by SIGPROF.
+ *
+ * A profiling interval timer interrupts the simulator at a fixed rate of
+ * host CPU time. The signal handler only bumps two preallocated histograms,
+ * one keyed by guest PC and one by active instruction handler, so the cost
+ * between samples is a single store per instruction (ACTIVE_HANDLER).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "sim.h"
+#include "shell.h"
+#include "decode.h"
+#include "disasm.h"
+#include "sample.h"
+
+volatile sig_atomic_t ACTIVE_HANDLER = HANDLER_NONE;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define SAMPLE_SLOTS (MEM_TEXT_SIZE >> 2)
+
+// samples indexed by (PC - MEM_TEXT_START) >> 2
+static uint32_t *pc_samples;
+
+// samples whose PC fell outside the text segment
+static uint32_t other_samples;
+
+// samples indexed by handler identifier
+static uint32_t handler_samples[HANDLER_SLOTS];
+
+static int sample_hz;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static void sample_signal(int sig) {
+	uint32_t slot = (CURRENT_STATE.PC - MEM_TEXT_START) >> 2;
+
+	if (slot < SAMPLE_SLOTS) {
+		pc_samples[slot]++;
+	} else {
+		other_samples++;
+	}
+
+	handler_samples[ACTIVE_HANDLER]++;
+}
+
+const char *handler_name(int id) {
+	const char *name = NULL;
+
+	if (id == HANDLER_NONE) {
+		return "(fetch/decode/shell)";
+	} else if (id >= HANDLER_TARGET(0)) {
+		name = TARGET_NAMES[id - HANDLER_TARGET(0)];
+	} else if (id >= HANDLER_FUNCTION(0)) {
+		name = FUNCTION_NAMES[id - HANDLER_FUNCTION(0)];
+	} else {
+		name = OPCODE_NAMES[id];
+	}
+
+	return name ? name : "unrecognized";
+}
+
+// sort slots by descending sample count
+static int compare_slots(const void *a, const void *b) {
+	uint32_t ca = pc_samples[*(const uint32_t *) a];
+	uint32_t cb = pc_samples[*(const uint32_t *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+// sort handler identifiers by descending sample count
+static int compare_handlers(const void *a, const void *b) {
+	uint32_t ca = handler_samples[*(const int *) a];
+	uint32_t cb = handler_samples[*(const int *) b];
+	return (ca < cb) - (ca > cb);
+}
+
+/* ----------------------------------------------------------------------------
+	Sampler Interface
+	See module header file (sample.h) for detailed function comments.
+*/
+
+int sample_start(int hz) {
+	struct sigaction sa;
+	struct itimerval timer;
+
+	if (hz <= 0 || hz > 1000000) {
+		return -1;
+	}
+
+	if (pc_samples == NULL) {
+		pc_samples = calloc(SAMPLE_SLOTS, sizeof(uint32_t));
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sample_signal;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGPROF, &sa, NULL) != 0) {
+		return -1;
+	}
+
+	long usec = 1000000 / hz;
+	timer.it_interval.tv_sec  = usec / 1000000;
+	timer.it_interval.tv_usec = usec % 1000000;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+		return -1;
+	}
+
+	sample_hz = hz;
+	return 0;
+}
+
+void sample_stop(void) {
+	struct itimerval timer;
+
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+void sample_report(FILE *out, int top_n) {
+	char text[64];
+	uint64_t total = other_samples;
+	uint32_t n = 0;
+
+	if (pc_samples == NULL) {
+		return;
+	}
+
+	uint32_t *slots = malloc(sizeof(uint32_t) * SAMPLE_SLOTS);
+	for (uint32_t slot = 0; slot < SAMPLE_SLOTS; slot++) {
+		if (pc_samples[slot]) {
+			total += pc_samples[slot];
+			slots[n++] = slot;
+		}
+	}
+	qsort(slots, n, sizeof(uint32_t), compare_slots);
+
+	fprintf(out, "\nSampled profile (%llu samples at %d Hz) :\n",
+		(unsigned long long) total, sample_hz);
+	fprintf(out, "-------------------------------------\n");
+	if (total == 0) {
+		fprintf(out, "  no samples (run too short for the sampling rate)\n\n");
+		free(slots);
+		return;
+	}
+
+	fprintf(out, "By PC:\n");
+	for (uint32_t i = 0; i < n && i < (uint32_t) top_n; i++) {
+		uint32_t pc = MEM_TEXT_START + (slots[i] << 2);
+		disasm(mem_read_32(pc), pc, text, sizeof(text));
+		fprintf(out, "  0x%08x  %10u  %6.2f%%  %s\n", pc, pc_samples[slots[i]],
+			100.0 * pc_samples[slots[i]] / total, text);
+	}
+	if (other_samples) {
+		fprintf(out, "  %-10s  %10u  %6.2f%%\n", "(other)", other_samples,
+			100.0 * other_samples / total);
+	}
+	free(slots);
+
+	int handlers[HANDLER_SLOTS];
+	for (int id = 0; id < HANDLER_SLOTS; id++) {
+		handlers[id] = id;
+	}
+	qsort(handlers, HANDLER_SLOTS, sizeof(int), compare_handlers);
+
+	fprintf(out, "By handler:\n");
+	for (int i = 0; i < HANDLER_SLOTS && handler_samples[handlers[i]]; i++) {
+		fprintf(out, "  %-20s  %10u  %6.2f%%\n", handler_name(handlers[i]),
+			handler_samples[handlers[i]], 100.0 * handler_samples[handlers[i]] / total);
+	}
+	fprintf(out, "\n");
+}
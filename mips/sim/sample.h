@@ -0,0 +1,49 @@
+/*
+ * sample.h
+ * Statistical sampling profiler driven by SIGPROF.
+ */
+
+#ifndef __SAMPLE_H
+#define __SAMPLE_H
+
+#include <stdio.h>
+#include <signal.h>
+
+#include "sim.h"
+
+// handler identifiers, one per dispatch table entry
+#define HANDLER_OPCODE(op)       (op)
+#define HANDLER_FUNCTION(func)   (DISPATCH_SIZE + (func))
+#define HANDLER_TARGET(target)   (2 * DISPATCH_SIZE + (target))
+#define HANDLER_NONE             (3 * DISPATCH_SIZE)
+#define HANDLER_SLOTS            (3 * DISPATCH_SIZE + 1)
+
+// instruction handler currently running, read by the sampling signal handler
+extern volatile sig_atomic_t ACTIVE_HANDLER;
+
+/*
+ * sample_start
+ * Start sampling the guest PC and active handler hz times per second of
+ * host CPU time. Returns 0 on success.
+ */
+int sample_start(int hz);
+
+/*
+ * sample_stop
+ * Stop the sampling timer.
+ */
+void sample_stop(void);
+
+/*
+ * handler_name
+ * Mnemonic of the handler behind a handler identifier.
+ */
+const char *handler_name(int id);
+
+/*
+ * sample_report
+ * Print the sample histograms by PC (top_n entries) and by handler.
+ */
+void sample_report(FILE *out, int top_n);
+
+#endif // __SAMPLE_H
@@ -0,0 +1,216 @@
+/*
+ * sched.c
+ * Time-slicing of many guest processes in one machine, enabled with -P.
+ *
+ * A context switch moves no guest memory: each process owns the host
+ * memory of its private regions, and switching points MEM_REGIONS and the
+ * page table at them. Registers, FPU state and the sbrk break are copied
+ * in and out, and the process's ASID is installed in EntryHi, so with the
+ * TLB on each process sees only its own (or global) TLB entries. Quanta are
+ * timed events, so the run loop pays nothing for the scheduler.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "sim.h"
+#include "shell.h"
+#include "fpu.h"
+#include "cp0.h"
+#include "tlb.h"
+#include "events.h"
+#include "syscalls.h"
+#include "sched.h"
+
+int SCHED_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+typedef struct {
+	char *program;
+	CPU_State state;
+	FPU_State fpu;
+	mem_region_t regions[MEM_NREGIONS];  // private regions, in place while running
+	uint32_t heap_break;
+	int live;
+	int exit_code;
+	uint64_t instructions;
+	uint64_t slices;                     // times switched in
+} Process;
+
+// kernel text is shared, every other region belongs to the process
+#define PROCESS_PRIVATE(i) (MEM_REGIONS[i].start != MEM_KTEXT_START)
+
+static Process *processes;
+static int process_count;
+static int running;
+
+static uint32_t quantum;
+static uint64_t slice_start;  // instruction count when the running process was switched in
+static uint64_t switches;
+
+static void quantum_expire(void *unused);
+
+static TimedEvent quantum_event = { .handler = quantum_expire };
+
+/* ----------------------------------------------------------------------------
+	Context Switching
+*/
+
+static void save(Process *p) {
+	p->state = CURRENT_STATE;
+	p->fpu = FPU;
+	p->heap_break = HEAP_BREAK;
+	p->instructions += INSTRUCTION_COUNT - slice_start;
+}
+
+static void restore(int index) {
+	Process *p = &processes[index];
+
+	running = index;
+	CURRENT_STATE = NEXT_STATE = p->state;
+	fpu_restore(&p->fpu);
+	HEAP_BREAK = p->heap_break;
+	EXIT_CODE = 0;
+
+	for (int i = 0; i < MEM_NREGIONS; i++) {
+		if (PROCESS_PRIVATE(i)) {
+			MEM_REGIONS[i] = p->regions[i];
+			mem_map_region(i);
+		}
+	}
+
+	// the process number is its ASID
+	CP0.REGS[CP0_ENTRYHI] = (CP0.REGS[CP0_ENTRYHI] & ~ENTRYHI_ASID) | index;
+	tlb_flush();
+
+	p->slices++;
+	slice_start = INSTRUCTION_COUNT;
+	event_schedule(&quantum_event, quantum);
+}
+
+/*
+ * next_live
+ * The next live process after the running one, round robin (the running
+ * one if it is alone), or -1 if none is left.
+ */
+static int next_live(void) {
+	for (int k = 1; k <= process_count; k++) {
+		int index = (running + k) % process_count;
+		if (processes[index].live) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+static void quantum_expire(void *unused) {
+	// don't switch inside an exception handler, or before a halt is retired
+	if (!RUN_BIT || (CP0.REGS[CP0_STATUS] & STATUS_EXL)) {
+		event_schedule(&quantum_event, 1);
+		return;
+	}
+
+	int next = next_live();
+	if (next == running) {
+		event_schedule(&quantum_event, quantum);
+		return;
+	}
+
+	save(&processes[running]);
+	switches++;
+	restore(next);
+}
+
+/* ----------------------------------------------------------------------------
+	Scheduler Interface
+	See module header file (sched.h) for detailed function comments.
+*/
+
+int sched_start(char **programs, int count, uint32_t slice) {
+	CPU_State initial = CURRENT_STATE;
+	int i;
+
+	if (count > MAX_PROCESSES) {
+		return -1;
+	}
+	processes = calloc(count, sizeof(Process));
+	process_count = count;
+	quantum = slice;
+
+	for (int k = 0; k < count; k++) {
+		Process *p = &processes[k];
+
+		// process 0 is the program already loaded, the others get fresh regions
+		if (k > 0) {
+			for (i = 0; i < MEM_NREGIONS; i++) {
+				if (PROCESS_PRIVATE(i)) {
+					MEM_REGIONS[i].mem = calloc(MEM_REGIONS[i].size, 1);
+					MEM_REGIONS[i].shared = FALSE;
+					mem_map_region(i);
+				}
+			}
+			CURRENT_STATE = initial;
+			load_program(programs[k]);
+		}
+
+		p->program = programs[k];
+		p->state = CURRENT_STATE;
+		p->fpu = FPU;
+		p->heap_break = HEAP_BREAK;
+		p->live = TRUE;
+		for (i = 0; i < MEM_NREGIONS; i++) {
+			p->regions[i] = MEM_REGIONS[i];
+		}
+	}
+
+	SCHED_ENABLED = TRUE;
+	restore(0);
+	return 0;
+}
+
+int sched_exit(void) {
+	Process *p = &processes[running];
+	int next;
+
+	save(p);
+	p->live = FALSE;
+	p->exit_code = EXIT_CODE;
+
+	if ((next = next_live()) < 0) {
+		// the batch fails with the first process that failed
+		for (int k = 0; k < process_count; k++) {
+			if (processes[k].exit_code) {
+				EXIT_CODE = processes[k].exit_code;
+				break;
+			}
+		}
+		event_cancel(&quantum_event);
+		return FALSE;
+	}
+
+	switches++;
+	restore(next);
+	RUN_BIT = TRUE;
+	return TRUE;
+}
+
+void sched_report(FILE *out) {
+	if (!SCHED_ENABLED) {
+		return;
+	}
+
+	fprintf(out, "\nProcesses : %d, quantum %u, %llu switches\n", process_count, quantum,
+		(unsigned long long) switches);
+	fprintf(out, "-------------------------------------\n");
+	for (int k = 0; k < process_count; k++) {
+		Process *p = &processes[k];
+		fprintf(out, "  %3d  %12llu instrs  %8llu slices  exit %-4d  %s%s\n", k,
+			(unsigned long long) p->instructions, (unsigned long long) p->slices,
+			p->exit_code, p->program, p->live ? " (running)" : "");
+	}
+	fprintf(out, "\n");
+}
@@ -0,0 +1,44 @@
+/*
+ * sched.h
+ * Time-slicing of many guest processes in one machine, enabled with -P.
+ *
+ * Each program file runs as its own process, with its own registers, FPU
+ * and address space, tagged by an ASID in CP0 EntryHi. Processes share
+ * kernel text (and so the exception handler), the devices and the console.
+ * Every quantum instructions the running process is switched out, round
+ * robin; a process that halts leaves the others running.
+ */
+
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define MAX_PROCESSES 256  // one per ASID
+
+// whether processes are being time-sliced
+extern int SCHED_ENABLED;
+
+/*
+ * sched_start
+ * Make the loaded machine state process 0, load each further program file
+ * as a new process and start switching every quantum instructions.
+ * Returns 0 on success, -1 if there are more than MAX_PROCESSES programs.
+ */
+int sched_start(char **programs, int count, uint32_t quantum);
+
+/*
+ * sched_exit
+ * Retire the running process after it halts and switch to the next one.
+ * Returns TRUE, with RUN_BIT set again, if any process is left to run.
+ */
+int sched_exit(void);
+
+/*
+ * sched_report
+ * Print instructions, time slices and exit code of each process.
+ */
+void sched_report(FILE *out);
+
+#endif // __SCHED_H
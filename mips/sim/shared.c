@@ -0,0 +1,213 @@
+/*
+ * shared.c
+ * Shared read-only program text images.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shared.h"
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+// one bit per page of the mapping, set once the page has been made private
+static uint8_t *cow_pages = NULL;
+
+// published image this instance holds a shared lock on until it exits
+static int image_fd = -1;
+static char image_path[448];
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+/*
+ * image_hash
+ * 64-bit FNV-1a hash of the text image, used to name the published file.
+ */
+static uint64_t image_hash(const uint8_t *image, uint32_t size) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (uint32_t i = 0; i < size; i++) {
+		hash ^= image[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/*
+ * image_used
+ * Size of the loaded part of the text region: up to the last non-zero
+ * byte, rounded up to whole pages.
+ */
+static uint32_t image_used(const uint8_t *image, uint32_t size) {
+	uint32_t used = size;
+
+	while (used > 0 && image[used - 1] == 0) {
+		used--;
+	}
+	used = (used + SHARED_PAGE_SIZE - 1) / SHARED_PAGE_SIZE * SHARED_PAGE_SIZE;
+
+	return used ? used : SHARED_PAGE_SIZE;
+}
+
+/*
+ * image_publish
+ * Write image to path atomically, so concurrent instances never observe
+ * a partially written file. Returns 0 on success, or if another instance
+ * published it first.
+ */
+static int image_publish(const char *path, const uint8_t *image, uint32_t size) {
+	char tmp[512];
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, (int) getpid());
+
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return -1;
+	}
+
+	uint32_t written = 0;
+	while (written < size) {
+		ssize_t n = write(fd, image + written, size - written);
+		if (n <= 0) {
+			close(fd);
+			unlink(tmp);
+			return -1;
+		}
+		written += n;
+	}
+	close(fd);
+
+	// never replace a published file: instances holding it decide when it goes
+	int status = link(tmp, path) == 0 || errno == EEXIST ? 0 : -1;
+	unlink(tmp);
+
+	return status;
+}
+
+/*
+ * image_open
+ * Open the published image at path, publishing it first if needed, and
+ * take a shared lock on it for the life of this instance. Returns the
+ * descriptor, or -1 on failure.
+ */
+static int image_open(const char *path, const uint8_t *image, uint32_t size) {
+	struct stat st;
+
+	for (int tries = 0; tries < 3; tries++) {
+		// image is published once, by the first instance to load this program
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			if (image_publish(path, image, size) != 0) {
+				return -1;
+			}
+			continue;
+		}
+
+		if (flock(fd, LOCK_SH) != 0 || fstat(fd, &st) != 0) {
+			close(fd);
+			return -1;
+		}
+
+		// the last instance may have removed it between our open and lock
+		if (st.st_nlink > 0) {
+			return fd;
+		}
+		close(fd);
+	}
+
+	return -1;
+}
+
+/*
+ * image_release
+ * At exit: remove the published image if no other instance holds it.
+ */
+static void image_release(void) {
+	struct stat held, st;
+
+	if (flock(image_fd, LOCK_EX | LOCK_NB) == 0 && fstat(image_fd, &held) == 0 &&
+			stat(image_path, &st) == 0 && held.st_dev == st.st_dev && held.st_ino == st.st_ino) {
+		unlink(image_path);
+	}
+	close(image_fd);
+}
+
+/* ----------------------------------------------------------------------------
+	Shared Text Interface
+	See module header file (shared.h) for detailed function comments.
+*/
+
+uint8_t *shared_text_map(const uint8_t *image, uint32_t size) {
+	struct stat st;
+	uint32_t used = image_used(image, size);
+
+	const char *dir = (stat(SHARED_TEXT_DIR, &st) == 0) ? SHARED_TEXT_DIR : "/tmp";
+	snprintf(image_path, sizeof(image_path), "%s/mips-text-%016llx", dir,
+		(unsigned long long) image_hash(image, used));
+
+	int fd = image_open(image_path, image, used);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	if (fstat(fd, &st) != 0 || st.st_size != used) {
+		close(fd);
+		return NULL;
+	}
+
+	// private mappings: pages are shared until written, then copied by the kernel;
+	// the unused tail of the region is zero-filled anonymous memory
+	uint8_t *mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+	if (mmap(mem, used, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(mem, size);
+		close(fd);
+		return NULL;
+	}
+
+	// guard against a hash collision with a different program
+	if (memcmp(mem, image, used) != 0) {
+		munmap(mem, size);
+		close(fd);
+		return NULL;
+	}
+
+	image_fd = fd;
+	atexit(image_release);
+
+	free(cow_pages);
+	cow_pages = calloc((size / SHARED_PAGE_SIZE + 7) / 8 + 1, 1);
+
+	return mem;
+}
+
+void shared_text_write(uint8_t *mem, uint32_t offset) {
+	uint32_t page = offset / SHARED_PAGE_SIZE;
+
+	if (cow_pages[page >> 3] & (1 << (page & 7))) {
+		return;
+	}
+
+	// write to text traps here: make this page (only) writable
+	if (mprotect(mem + page * SHARED_PAGE_SIZE, SHARED_PAGE_SIZE, PROT_READ | PROT_WRITE) != 0) {
+		perror("mprotect");
+		exit(-1);
+	}
+
+	cow_pages[page >> 3] |= (1 << (page & 7));
+}
@@ -0,0 +1,38 @@
+/*
+ * shared.h
+ * Shared read-only program text images.
+ */
+
+#ifndef __SHARED_H
+#define __SHARED_H
+
+#include <stdint.h>
+
+// directory holding published text images (mips-text-<hash>), falls back to
+// /tmp. The last instance using an image removes it at exit; images left by
+// killed instances can be deleted with rm at any time, running instances
+// keep their mapping.
+#define SHARED_TEXT_DIR "/dev/shm"
+
+// size of copy-on-write granule within a shared text image
+#define SHARED_PAGE_SIZE 4096
+
+/*
+ * shared_text_map
+ * Publish (or reuse an already published) copy of the loaded part of a
+ * text image and map it read-only into this process, covering all size
+ * bytes. Instances loading identical images share the same physical pages.
+ * Returns the mapping, or NULL if the image could not be shared (caller
+ * keeps its private copy).
+ */
+uint8_t *shared_text_map(const uint8_t *image, uint32_t size);
+
+/*
+ * shared_text_write
+ * Prepare the page containing offset for a write. The first write to a
+ * page of the shared mapping makes it writable, and the kernel then
+ * gives this instance a private copy of that page only.
+ */
+void shared_text_write(uint8_t *mem, uint32_t offset);
+
+#endif // __SHARED_H
@@ -10,29 +10,39 @@
 #include <stdint.h>
 #include <assert.h>
 
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
 #include "sim.h"
 #include "shell.h"
+#include "shared.h"
+#include "simt.h"
+#include "stats.h"
+#include "profile.h"
+#include "sample.h"
+#include "cache.h"
+#include "bpred.h"
+#include "timing.h"
+#include "retire.h"
+#include "callgraph.h"
+#include "heatmap.h"
+#include "trace.h"
+#include "cost.h"
+#include "live.h"
+#include "syscalls.h"
+#include "native.h"
+#include "cp0.h"
+#include "events.h"
+#include "mmio.h"
+#include "devices.h"
+#include "tlb.h"
+#include "sched.h"
 
 /***************************************************************/
 /* Main memory.                                                */
 /***************************************************************/
 
-#define MEM_DATA_START  0x10000000
-#define MEM_DATA_SIZE   0x00100000
-#define MEM_TEXT_START  0x00400000
-#define MEM_TEXT_SIZE   0x00100000
-#define MEM_STACK_START 0x7ff00000
-#define MEM_STACK_SIZE  0x00100000
-#define MEM_KDATA_START 0x90000000
-#define MEM_KDATA_SIZE  0x00100000
-#define MEM_KTEXT_START 0x80000000
-#define MEM_KTEXT_SIZE  0x00100000
-
-typedef struct {
-    uint32_t start, size;
-    uint8_t *mem;
-} mem_region_t;
-
 /* memory will be dynamically allocated at initialization */
 mem_region_t MEM_REGIONS[] = {
     { MEM_TEXT_START,  MEM_TEXT_SIZE,  NULL },
@@ -42,7 +52,8 @@ mem_region_t MEM_REGIONS[] = {
     { MEM_KTEXT_START, MEM_KTEXT_SIZE, NULL }
 };
 
-#define MEM_NREGIONS (sizeof(MEM_REGIONS) / sizeof(mem_region_t))
+/* page attributes, filled in from MEM_REGIONS and the devices */
+mem_page_t MEM_PAGES[PAGE_COUNT];
 
 /***************************************************************/
 /* CPU State info.                                             */
@@ -52,7 +63,36 @@ CPU_State CURRENT_STATE;
 CPU_State NEXT_STATE;
 
 int RUN_BIT;	
-int INSTRUCTION_COUNT;
+uint64_t INSTRUCTION_COUNT;
+
+int SHARED_TEXT;	/* share text image across instances */
+char *LOCKSTEP_INPUTS;	/* run a SIMT batch over these inputs */
+int BATCH_MODE;		/* run to completion without the shell */
+char *STATS_JSON;	/* batch mode instruction mix export */
+int PROFILE_TOP;	/* hottest PCs reported at halt */
+char *CALLGRIND_FILE;	/* callgrind export of the PC profile */
+char *PROGRAM_NAME;	/* first program file */
+int SAMPLE_HZ;		/* sampling profiler rate, 0 = off */
+int DECOUPLED;		/* run analysis consumers on their own threads */
+int CALLGRAPH_TOP;	/* functions reported by the call-graph profiler */
+char *FOLDED_FILE;	/* folded call stacks export */
+int HEATMAP_TOP;	/* hottest pages per region in the heatmap report */
+char *HEATMAP_FILE;	/* per-line memory heatmap export */
+uint32_t HEATMAP_WINDOW = 100000;	/* instructions per working-set window */
+char *TRACE_FILE;	/* Chrome trace export */
+char *LIVE_NAME;	/* shared memory segment for live statistics */
+char *HANDLER_FILE;	/* exception handler loaded at the exception vector */
+char *DISK_FILE;	/* host file backing the block device */
+int SCHED_QUANTUM;	/* time-slice one process per program file */
+
+/* options the lockstep batch (-l) doesn't support: its lanes bypass the
+   analysis consumers, events and exceptions, and it reports no statistics */
+#define LOCKSTEP_UNSUPPORTED "jpgCFmMesBcTHLNkKDVP"
+
+#define SAMPLE_TOP 20	/* PCs listed in the sampled profile */
+#define CACHE_TOP 10	/* PCs listed in the cache miss reports */
+#define BPRED_TOP 10	/* PCs listed in the branch prediction report */
+#define TRACE_EVENTS (1 << 20)	/* trace buffer capacity */
 
 /***************************************************************/
 /*                                                             */
@@ -62,22 +102,26 @@ int INSTRUCTION_COUNT;
 /*                                                             */
 /***************************************************************/
 uint32_t mem_read_32(uint32_t address) {
-    int i;
-    for (i = 0; i < MEM_NREGIONS; i++) {
-        if (address >= MEM_REGIONS[i].start &&
-                address < (MEM_REGIONS[i].start + MEM_REGIONS[i].size)) {
-            
-            uint32_t offset = address - MEM_REGIONS[i].start;
-
-            return
-                (MEM_REGIONS[i].mem[offset+3] << 24) |
-                (MEM_REGIONS[i].mem[offset+2] << 16) |
-                (MEM_REGIONS[i].mem[offset+1] <<  8) |
-                (MEM_REGIONS[i].mem[offset+0] <<  0);
-        }
+    mem_page_t *page = &MEM_PAGES[address >> PAGE_BITS];
+    uint32_t value = 0;
+    uint64_t start = COST_ENABLED ? cost_now() : 0;
+
+    if (page->attr & PAGE_READ) {
+        uint8_t *mem = page->mem + (address & PAGE_MASK);
+
+        value =
+            (mem[3] << 24) |
+            (mem[2] << 16) |
+            (mem[1] <<  8) |
+            (mem[0] <<  0);
+    } else if (page->attr & PAGE_MMIO) {
+        value = mmio_read(address);
     }
 
-    return 0;
+    if (COST_ENABLED) {
+        cost_add(COST_MEM_READ, cost_now() - start);
+    }
+    return value;
 }
 
 /***************************************************************/
@@ -88,20 +132,102 @@ uint32_t mem_read_32(uint32_t address) {
 /*                                                             */
 /***************************************************************/
 void mem_write_32(uint32_t address, uint32_t value) {
+    mem_page_t *page = &MEM_PAGES[address >> PAGE_BITS];
+    uint64_t start = COST_ENABLED ? cost_now() : 0;
+
+    if (page->attr & PAGE_READ) {
+        uint8_t *mem = page->mem + (address & PAGE_MASK);
+
+        /* pages of a read-only shared image get a private copy first */
+        if (!(page->attr & PAGE_WRITE)) {
+            int i;
+            for (i = 0; i < MEM_NREGIONS; i++) {
+                if (address >= MEM_REGIONS[i].start &&
+                        address < (MEM_REGIONS[i].start + MEM_REGIONS[i].size)) {
+                    uint32_t offset = address - MEM_REGIONS[i].start;
+                    shared_text_write(MEM_REGIONS[i].mem, offset);
+                    shared_text_write(MEM_REGIONS[i].mem, offset+3);
+                    break;
+                }
+            }
+        }
+
+        mem[3] = (value >> 24) & 0xFF;
+        mem[2] = (value >> 16) & 0xFF;
+        mem[1] = (value >>  8) & 0xFF;
+        mem[0] = (value >>  0) & 0xFF;
+    } else if (page->attr & PAGE_MMIO) {
+        mmio_write(address, value);
+    }
+
+    if (COST_ENABLED) {
+        cost_add(COST_MEM_WRITE, cost_now() - start);
+    }
+}
+
+/***************************************************************/
+/*                                                             */
+/* Procedure: mem_span                                         */
+/*                                                             */
+/* Purpose: Host pointer to guest memory at address, with the  */
+/*          bytes up to the end of its region in available.    */
+/*          NULL if unmapped, or if writable is requested and  */
+/*          the region is a read-only shared image.            */
+/*                                                             */
+/***************************************************************/
+uint8_t *mem_span(uint32_t address, uint32_t *available, int writable) {
     int i;
     for (i = 0; i < MEM_NREGIONS; i++) {
         if (address >= MEM_REGIONS[i].start &&
                 address < (MEM_REGIONS[i].start + MEM_REGIONS[i].size)) {
-            
+
             uint32_t offset = address - MEM_REGIONS[i].start;
 
-            MEM_REGIONS[i].mem[offset+3] = (value >> 24) & 0xFF;
-            MEM_REGIONS[i].mem[offset+2] = (value >> 16) & 0xFF;
-            MEM_REGIONS[i].mem[offset+1] = (value >>  8) & 0xFF;
-            MEM_REGIONS[i].mem[offset+0] = (value >>  0) & 0xFF;
-            return;
+            if (writable && MEM_REGIONS[i].shared)
+                return NULL;
+
+            *available = MEM_REGIONS[i].size - offset;
+            return MEM_REGIONS[i].mem + offset;
         }
     }
+
+    return NULL;
+}
+
+/***************************************************************/
+/*                                                             */
+/* Procedure: mem_map_region                                   */
+/*                                                             */
+/* Purpose: Point the pages of a region at its host memory.    */
+/*          Called whenever the region's memory is replaced.   */
+/*                                                             */
+/***************************************************************/
+void mem_map_region(int region) {
+    mem_region_t *r = &MEM_REGIONS[region];
+    uint32_t offset;
+
+    for (offset = 0; offset < r->size; offset += 1 << PAGE_BITS) {
+        mem_page_t *page = &MEM_PAGES[(r->start + offset) >> PAGE_BITS];
+        page->mem  = r->mem + offset;
+        page->attr = r->shared ? PAGE_READ : PAGE_READ | PAGE_WRITE;
+    }
+}
+
+/***************************************************************/
+/*                                                             */
+/* Procedure: mem_map_device                                   */
+/*                                                             */
+/* Purpose: Send accesses to the pages covering a device's     */
+/*          registers through the MMIO dispatch.               */
+/*                                                             */
+/***************************************************************/
+void mem_map_device(uint32_t start, uint32_t size) {
+    uint32_t page;
+
+    for (page = start >> PAGE_BITS; page <= (start + size - 1) >> PAGE_BITS; page++) {
+        MEM_PAGES[page].mem  = NULL;
+        MEM_PAGES[page].attr = PAGE_MMIO;
+    }
 }
 
 /***************************************************************/
@@ -119,6 +245,7 @@ void help() {
   printf("input reg_num reg_val - set GPR reg_num to reg_val    \n");
   printf("high value            - set the HI register to value  \n");
   printf("low value             - set the LO register to value  \n");
+  printf("stats                 - show instruction mix counters \n");
   printf("?                     - display this help menu        \n");
   printf("quit                  - exit the program              \n\n");
 }
@@ -131,13 +258,61 @@ void help() {
 /*                                                             */
 /***************************************************************/
 void cycle() {
-  printf("Cycle : %d\n", INSTRUCTION_COUNT);		
+  if (!BATCH_MODE)
+    printf("Cycle : %llu\n", (unsigned long long) INSTRUCTION_COUNT);		
   process_instruction();
   CURRENT_STATE = NEXT_STATE;
   INSTRUCTION_COUNT++;
 }
 
 
+/***************************************************************/
+/*                                                             */
+/* Procedure : halt_reports                                    */
+/*                                                             */
+/* Purpose   : Emit end-of-run reports of enabled profilers.   */
+/*                                                             */
+/***************************************************************/
+void halt_reports() {
+  retire_drain();
+
+  if (SAMPLE_HZ) {
+    sample_stop();
+    sample_report(stdout, SAMPLE_TOP);
+  }
+
+  if (PROFILE_TOP)
+    profile_report(stdout, PROFILE_TOP);
+
+  cache_report(&ICACHE, stdout, CACHE_TOP);
+  cache_report(&DCACHE, stdout, CACHE_TOP);
+  bpred_report(stdout, BPRED_TOP);
+  timing_report(stdout);
+  cost_report(stdout);
+  native_report(stdout);
+  cp0_report(stdout);
+  tlb_report(stdout);
+  sched_report(stdout);
+
+  if (CALLGRAPH_TOP)
+    callgraph_report(stdout, CALLGRAPH_TOP);
+
+  if (FOLDED_FILE && callgraph_folded(FOLDED_FILE) != 0)
+    printf("Error: Can't write folded stacks file %s\n", FOLDED_FILE);
+
+  if (HEATMAP_TOP)
+    heatmap_report(stdout, HEATMAP_TOP);
+
+  if (HEATMAP_FILE && heatmap_export(HEATMAP_FILE) != 0)
+    printf("Error: Can't write heatmap file %s\n", HEATMAP_FILE);
+
+  if (TRACE_FILE && trace_export(TRACE_FILE) != 0)
+    printf("Error: Can't write trace file %s\n", TRACE_FILE);
+
+  if (CALLGRIND_FILE && profile_callgrind(CALLGRIND_FILE, PROGRAM_NAME) != 0)
+    printf("Error: Can't write callgrind file %s\n", CALLGRIND_FILE);
+}
+
 /***************************************************************/
 /*                                                             */
 /* Procedure : go                                              */
@@ -152,9 +327,19 @@ void go() {
   }
 
   printf("Simulating...\n\n");
-  while (RUN_BIT)
+  /* with processes, a halt only retires the running one */
+  while (RUN_BIT || (SCHED_ENABLED && sched_exit())) {
     cycle();
+    if (INSTRUCTION_COUNT >= EVENT_NEXT)
+      event_run();
+  }
+  syscall_flush();
   printf("Simulator halted\n\n");
+
+  if (LIVE_ENABLED)
+    live_halt();
+
+  halt_reports();
 }
 
 /***************************************************************/ 
@@ -184,7 +369,7 @@ void mdump(FILE * dumpsim_file, int start, int stop) {
 
 /***************************************************************/
 /*                                                             */
-/* Procedure : rdump                                           */.7
+/* Procedure : rdump                                           */
 /*                                                             */
 /* Purpose   : Dump current register and bus values to the     */   
 /*             output file.                                    */
@@ -193,9 +378,13 @@ void mdump(FILE * dumpsim_file, int start, int stop) {
 void rdump(FILE * dumpsim_file) {                               
   int k; 
 
+  retire_drain();
+
   printf("\nCurrent register/bus values :\n");
   printf("-------------------------------------\n");
-  printf("Instruction Count : %u\n", INSTRUCTION_COUNT);
+  printf("Instruction Count : %llu\n", (unsigned long long) INSTRUCTION_COUNT);
+  if (TIMING.enabled)
+    printf("Cycles            : %llu\n", (unsigned long long) TIMING.cycles);
   printf("PC                : 0x%08x\n", CURRENT_STATE.PC);
   printf("Registers:\n");
   for (k = 0; k < MIPS_REGS; k++)
@@ -207,7 +396,9 @@ void rdump(FILE * dumpsim_file) {
   // dump the state information into the dumpsim file 
   fprintf(dumpsim_file, "\nCurrent register/bus values :\n");
   fprintf(dumpsim_file, "-------------------------------------\n");
-  fprintf(dumpsim_file, "Instruction Count : %u\n", INSTRUCTION_COUNT);
+  fprintf(dumpsim_file, "Instruction Count : %llu\n", (unsigned long long) INSTRUCTION_COUNT);
+  if (TIMING.enabled)
+    fprintf(dumpsim_file, "Cycles            : %llu\n", (unsigned long long) TIMING.cycles);
   fprintf(dumpsim_file, "PC                : 0x%08x\n", CURRENT_STATE.PC);
   fprintf(dumpsim_file, "Registers:\n");
   for (k = 0; k < MIPS_REGS; k++)
@@ -255,6 +446,12 @@ void get_command(FILE * dumpsim_file) {
     help();
     break;
 
+  case 'S':
+  case 's':
+    stats_print(stdout);
+    stats_print(dumpsim_file);
+    break;
+
   case 'Q':
   case 'q':
     printf("Bye.\n");
@@ -304,12 +501,37 @@ void get_command(FILE * dumpsim_file) {
 /***************************************************************/
 void init_memory() {                                           
     int i;
+    /* calloc'd pages are only made resident once touched */
     for (i = 0; i < MEM_NREGIONS; i++) {
-        MEM_REGIONS[i].mem = malloc(MEM_REGIONS[i].size);
-        memset(MEM_REGIONS[i].mem, 0, MEM_REGIONS[i].size);
+        MEM_REGIONS[i].mem = calloc(MEM_REGIONS[i].size, 1);
+        mem_map_region(i);
     }
 }
 
+/***************************************************************/
+/*                                                             */
+/* Procedure : share_text                                      */
+/*                                                             */
+/* Purpose   : Replace the private text region with a read-    */
+/*             only mapping shared by all instances running    */
+/*             the same program image.                         */
+/*                                                             */
+/***************************************************************/
+void share_text() {
+    mem_region_t *text = &MEM_REGIONS[0];
+    uint8_t *mem = shared_text_map(text->mem, text->size);
+
+    if (mem == NULL) {
+        printf("Warning: Can't share text image, using private copy\n\n");
+        return;
+    }
+
+    free(text->mem);
+    text->mem    = mem;
+    text->shared = TRUE;
+    mem_map_region(0);
+}
+
 /**************************************************************/
 /*                                                            */
 /* Procedure : load_program                                   */
@@ -340,6 +562,34 @@ void load_program(char *program_filename) {
   printf("Read %d words from program into memory.\n\n", ii/4);
 }
 
+/**************************************************************/
+/*                                                            */
+/* Procedure : load_handler                                   */
+/*                                                            */
+/* Purpose   : Load the exception handler at the exception    */
+/*             vector in kernel text.                         */
+/*                                                            */
+/**************************************************************/
+void load_handler(char *handler_filename) {
+  FILE *handler;
+  int ii, word;
+
+  handler = fopen(handler_filename, "r");
+  if (handler == NULL) {
+    printf("Error: Can't open exception handler file %s\n", handler_filename);
+    exit(-1);
+  }
+
+  ii = 0;
+  while (fscanf(handler, "%x\n", &word) != EOF) {
+    mem_write_32(EXCEPTION_VECTOR + ii, word);
+    ii += 4;
+  }
+  fclose(handler);
+
+  printf("Read %d words of exception handler at 0x%08x.\n\n", ii/4, EXCEPTION_VECTOR);
+}
+
 /************************************************************/
 /*                                                          */
 /* Procedure : initialize                                   */
@@ -357,10 +607,114 @@ void initialize(char *program_filename, int num_prog_files) {
     while(*program_filename++ != '\0');
   }
 
+  if (HANDLER_FILE)
+    load_handler(HANDLER_FILE);
+
+  if (SHARED_TEXT)
+    share_text();
+
   NEXT_STATE = CURRENT_STATE;
   RUN_BIT    = TRUE;
 }
 
+/***************************************************************/
+/*                                                             */
+/* Procedure : host_seconds                                    */
+/*                                                             */
+/* Purpose   : Monotonic host time, in seconds.                */
+/*                                                             */
+/***************************************************************/
+double host_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/***************************************************************/
+/*                                                             */
+/* Procedure : host_report                                     */
+/*                                                             */
+/* Purpose   : Print simulator throughput for a batch run as   */
+/*             key=value pairs (read by bench/bench.sh).       */
+/*                                                             */
+/***************************************************************/
+void host_report(double seconds) {
+  struct rusage usage;
+  uint64_t instructions = stats_instructions();
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("Host perf : instructions=%llu seconds=%.6f mips=%.3f ns_per_instr=%.3f peak_rss_kb=%ld\n",
+         (unsigned long long) instructions, seconds,
+         seconds > 0 ? instructions / seconds / 1e6 : 0.0,
+         instructions ? seconds * 1e9 / instructions : 0.0,
+         usage.ru_maxrss);
+}
+
+/***************************************************************/
+/*                                                             */
+/* Procedure : write_stats_json                                */
+/*                                                             */
+/* Purpose   : Export instruction mix counters ("-" = stdout). */
+/*                                                             */
+/***************************************************************/
+void write_stats_json(char *filename) {
+  FILE *out = strcmp(filename, "-") ? fopen(filename, "w") : stdout;
+
+  if (out == NULL) {
+    printf("Error: Can't open stats file %s\n", filename);
+    return;
+  }
+
+  stats_json(out);
+  if (out != stdout)
+    fclose(out);
+}
+
+/***************************************************************/
+/*                                                             */
+/* Procedure : usage                                           */
+/*                                                             */
+/* Purpose   : Print command line usage and exit.              */
+/*                                                             */
+/***************************************************************/
+void usage(char *prog) {
+  printf("Error: usage: %s [-t] [-b] [-j file] [-p n] [-g file] [-C n] [-F file] [-m n] [-M file] [-W n] [-e file] [-s hz] [-c cache] [-B models] [-T timing] [-H] [-L name] [-N map] [-k file] [-K addr] [-D file] [-V] [-P n] [-A] [-l inputs] <program_file_1> <program_file_2> ...\n", prog);
+  printf("  -t         share read-only text image across instances, published as\n");
+  printf("             /dev/shm/mips-text-* until the last instance exits\n");
+  printf("  -b         batch mode: run to completion, dump registers and exit\n");
+  printf("  -j file    batch mode: write instruction mix counters as JSON to file\n");
+  printf("  -p n       profile PCs, report the n hottest and a listing at halt\n");
+  printf("  -g file    profile PCs, write callgrind output to file at halt\n");
+  printf("  -C n       profile the call graph, report the n heaviest functions at halt\n");
+  printf("  -F file    profile the call graph, write folded stacks to file at halt\n");
+  printf("  -m n       track memory accesses, report working sets, reuse distances\n");
+  printf("             and the n hottest pages of each region at halt\n");
+  printf("  -M file    track memory accesses, write a per-line heatmap CSV to file at halt\n");
+  printf("  -W n       working-set window of n instructions (default 100000)\n");
+  printf("  -e file    trace calls, syscalls and phase markers (syscalls 100/101), write\n");
+  printf("             Chrome trace JSON to file at halt\n");
+  printf("  -s hz      sample guest PC and handler hz times per CPU second, report at halt\n");
+  printf("  -c cache   model an L1 cache, cache is i|d:size:assoc:line[:lru|plru|random],\n");
+  printf("             e.g. d:32k:4:32:lru; may be given once for each cache\n");
+  printf("  -B models  run branch predictors (static,bimodal,gshare,tage,ras or all), report at halt\n");
+  printf("  -T timing  model a 5-stage pipeline, timing is default or a list of forward,\n");
+  printf("             noforward, mult=N, div=N, branch=N, jump=N; reports cycles and CPI\n");
+  printf("  -H         time each instruction handler and memory access, report at halt\n");
+  printf("  -L name    publish live statistics in shared memory segment name, for simtop\n");
+  printf("  -N map     run memcpy, memset and strlen natively at their addresses in symbol map\n");
+  printf("  -k file    load an exception handler at the exception vector (default 0x%08x)\n",
+         EXCEPTION_VECTOR_DEFAULT);
+  printf("  -K addr    move the exception vector to addr in kernel text\n");
+  printf("  -D file    back the block device at 0x%08x with file\n", BLOCK_BASE);
+  printf("  -V         translate addresses through a MIPS32 TLB; kuseg is mapped, so a\n");
+  printf("             refill handler (-k) must map the program's pages\n");
+  printf("  -P n       run each program file as a process, switching every n instructions\n");
+  printf("  -A         run profile, cache, predictor and timing analysis on separate threads\n");
+  printf("  -l inputs  run one instance per line of inputs in lockstep, then exit\n");
+  exit(1);
+}
+
 /***************************************************************/
 /*                                                             */
 /* Procedure : main                                            */
@@ -368,26 +722,195 @@ void initialize(char *program_filename, int num_prog_files) {
 /***************************************************************/
 int main(int argc, char *argv[]) {                              
   FILE *dumpsim_file;
+  int opt, unsupported = 0;
+
+  while ((opt = getopt(argc, argv, "tbj:p:g:C:F:m:M:W:e:s:c:B:T:HL:N:k:K:D:VP:Al:")) != -1) {
+    if (strchr(LOCKSTEP_UNSUPPORTED, opt))
+      unsupported = opt;
 
-  if (argc < 2) {
-    printf("Error: usage: %s <program_file_1> <program_file_2> ...\n", argv[0]);
-    exit(1);
+    switch (opt) {
+    case 't':
+      SHARED_TEXT = TRUE;
+      break;
+    case 'b':
+      BATCH_MODE = TRUE;
+      break;
+    case 'j':
+      BATCH_MODE = TRUE;
+      STATS_JSON = optarg;
+      break;
+    case 'p':
+      PROFILE_TOP = atoi(optarg);
+      profile_enable();
+      break;
+    case 'g':
+      CALLGRIND_FILE = optarg;
+      profile_enable();
+      break;
+    case 'C':
+      CALLGRAPH_TOP = atoi(optarg);
+      callgraph_enable();
+      break;
+    case 'F':
+      FOLDED_FILE = optarg;
+      callgraph_enable();
+      break;
+    case 'm':
+      HEATMAP_TOP = atoi(optarg);
+      break;
+    case 'M':
+      HEATMAP_FILE = optarg;
+      break;
+    case 'W':
+      HEATMAP_WINDOW = atoi(optarg);
+      break;
+    case 'e':
+      TRACE_FILE = optarg;
+      if (trace_enable(TRACE_EVENTS) != 0) {
+        printf("Error: Can't allocate trace buffer\n");
+        exit(-1);
+      }
+      break;
+    case 's':
+      SAMPLE_HZ = atoi(optarg);
+      break;
+    case 'c':
+      if (cache_configure(optarg) != 0) {
+        printf("Error: Bad cache configuration %s\n", optarg);
+        usage(argv[0]);
+      }
+      break;
+    case 'B':
+      if (bpred_configure(optarg) != 0) {
+        printf("Error: Bad branch predictor list %s\n", optarg);
+        usage(argv[0]);
+      }
+      break;
+    case 'T':
+      if (timing_configure(optarg) != 0) {
+        printf("Error: Bad timing configuration %s\n", optarg);
+        usage(argv[0]);
+      }
+      break;
+    case 'H':
+      cost_enable();
+      break;
+    case 'L':
+      LIVE_NAME = optarg;
+      break;
+    case 'N':
+      if (native_load(optarg) < 0) {
+        printf("Error: Can't open symbol map %s\n", optarg);
+        exit(-1);
+      }
+      break;
+    case 'k':
+      HANDLER_FILE = optarg;
+      break;
+    case 'K':
+      EXCEPTION_VECTOR = (uint32_t) strtoul(optarg, NULL, 0);
+      if (EXCEPTION_VECTOR < MEM_KTEXT_START || EXCEPTION_VECTOR >= MEM_KTEXT_START + MEM_KTEXT_SIZE ||
+          (EXCEPTION_VECTOR & 3)) {
+        printf("Error: Exception vector %s is not a word in kernel text\n", optarg);
+        usage(argv[0]);
+      }
+      break;
+    case 'D':
+      DISK_FILE = optarg;
+      break;
+    case 'V':
+      tlb_enable();
+      break;
+    case 'P':
+      SCHED_QUANTUM = atoi(optarg);
+      if (SCHED_QUANTUM <= 0) {
+        printf("Error: Quantum %s is not a positive instruction count\n", optarg);
+        usage(argv[0]);
+      }
+      break;
+    case 'A':
+      DECOUPLED = TRUE;
+      break;
+    case 'l':
+      LOCKSTEP_INPUTS = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  if (optind >= argc)
+    usage(argv[0]);
+
+  if (LOCKSTEP_INPUTS && unsupported) {
+    printf("Error: -%c can't be combined with -l\n", unsupported);
+    usage(argv[0]);
   }
 
   printf("MIPS Simulator\n\n");
 
-  initialize(argv[1], argc - 1);
+  PROGRAM_NAME = argv[optind];
+  /* processes load their own program files */
+  initialize(argv[optind], SCHED_QUANTUM ? 1 : argc - optind);
+
+  if (devices_init(DISK_FILE) != 0) {
+    printf("Error: Can't open disk file %s\n", DISK_FILE);
+    exit(-1);
+  }
+
+  if (SCHED_QUANTUM && sched_start(argv + optind, argc - optind, SCHED_QUANTUM) != 0) {
+    printf("Error: Can't run more than %d processes\n", MAX_PROCESSES);
+    exit(-1);
+  }
 
   // initialize opcode and function dispatchers
   init_opcode_dispatch(); 
   init_function_dispatch();
   init_target_dispatch(); 
 
+  // the window size may follow -m/-M on the command line
+  if (HEATMAP_TOP || HEATMAP_FILE)
+    heatmap_enable(HEATMAP_WINDOW);
+
+  if (LIVE_NAME && live_enable(LIVE_NAME, PROGRAM_NAME) != 0) {
+    printf("Error: Can't create shared memory segment %s\n", LIVE_NAME);
+    exit(-1);
+  }
+
+  // feed enabled analyses from retired instruction records
+  retire_start(DECOUPLED);
+
+  if (SAMPLE_HZ && sample_start(SAMPLE_HZ) != 0) {
+    printf("Error: Can't start sampling at %d Hz\n", SAMPLE_HZ);
+    exit(-1);
+  }
+
+  if (LOCKSTEP_INPUTS) {
+    double start = host_seconds();
+    if (simt_run(LOCKSTEP_INPUTS, stdout) < 0) {
+      printf("Error: Can't open inputs file %s\n", LOCKSTEP_INPUTS);
+      exit(-1);
+    }
+    syscall_flush();
+    host_report(host_seconds() - start);
+    exit(0);
+  }
+
   if ((dumpsim_file = fopen("dumpsim", "w")) == NULL) {
     printf("Error: Can't open dumpsim file\n");
     exit(-1);
   }
 
+  if (BATCH_MODE) {
+    double start = host_seconds();
+    go();
+    host_report(host_seconds() - start);
+    rdump(dumpsim_file);
+    if (STATS_JSON)
+      write_stats_json(STATS_JSON);
+    exit(EXIT_CODE);
+  }
+
   while (1)
     get_command(dumpsim_file);
 }
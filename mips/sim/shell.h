@@ -21,13 +21,64 @@ typedef struct CPU_State_Struct {
   uint32_t LO;               // special register for mul/div
 } CPU_State;
 
+/***************************************************************/
+/* Main memory.                                                */
+/***************************************************************/
+
+#define MEM_DATA_START  0x10000000
+#define MEM_DATA_SIZE   0x00100000
+#define MEM_TEXT_START  0x00400000
+#define MEM_TEXT_SIZE   0x00100000
+#define MEM_STACK_START 0x7ff00000
+#define MEM_STACK_SIZE  0x00100000
+#define MEM_KDATA_START 0x90000000
+#define MEM_KDATA_SIZE  0x00100000
+#define MEM_KTEXT_START 0x80000000
+#define MEM_KTEXT_SIZE  0x00100000
+
+typedef struct {
+    uint32_t start, size;
+    uint8_t *mem;
+    int shared;     /* mapped read-only from a shared image */
+} mem_region_t;
+
+#define MEM_NREGIONS 5
+
+extern mem_region_t MEM_REGIONS[MEM_NREGIONS];
+
+/***************************************************************/
+/* Page table: attributes of every 64K page of the address     */
+/* space, so RAM accesses skip the region search.              */
+/***************************************************************/
+
+#define PAGE_BITS  16
+#define PAGE_MASK  ((1 << PAGE_BITS) - 1)
+#define PAGE_COUNT (1 << (32 - PAGE_BITS))
+
+/* page attributes, 0 = unmapped (reads 0, writes ignored) */
+#define PAGE_READ  0x1  /* host memory at mem can be read */
+#define PAGE_WRITE 0x2  /* host memory at mem can be written */
+#define PAGE_MMIO  0x4  /* device registers, see mmio.h */
+
+typedef struct {
+    uint8_t *mem;   /* host address of the page */
+    int attr;
+} mem_page_t;
+
+extern mem_page_t MEM_PAGES[PAGE_COUNT];
+
 extern CPU_State CURRENT_STATE;
 extern CPU_State NEXT_STATE;
 
 extern int RUN_BIT;	/* run bit */
+extern uint64_t INSTRUCTION_COUNT;	/* instructions executed so far */
 
 uint32_t mem_read_32  (uint32_t address);
 void     mem_write_32 (uint32_t address, uint32_t value);
+uint8_t *mem_span     (uint32_t address, uint32_t *available, int writable);
+void     mem_map_region (int region);
+void     mem_map_device (uint32_t start, uint32_t size);
+void     load_program   (char *program_filename);
 
 void process_instruction();
 
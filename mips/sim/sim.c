@@ -11,6 +11,17 @@
 #include "mips.h"
 #include "shell.h"
 #include "decode.h"
+#include "stats.h"
+#include "sample.h"
+#include "retire.h"
+#include "trace.h"
+#include "cost.h"
+#include "syscalls.h"
+#include "native.h"
+#include "fpu.h"
+#include "cp0.h"
+#include "tlb.h"
+#include "mmio.h"
 
 /* ----------------------------------------------------------------------------
 	Instruction Handler Dipatch
@@ -44,6 +55,8 @@ int handle_andi(uint32_t instr);
 int handle_ori(uint32_t instr);
 int handle_xori(uint32_t instr);
 int handle_lui(uint32_t instr);
+int handle_special2(uint32_t instr);
+int handle_special3(uint32_t instr);
 int handle_lb(uint32_t instr);
 int handle_lh(uint32_t instr);
 int handle_lw(uint32_t instr);
@@ -65,6 +78,8 @@ int handle_srlv(uint32_t instr);
 int handle_srav(uint32_t instr);
 int handle_jr(uint32_t instr);
 int handle_jalr(uint32_t instr);
+int handle_movz(uint32_t instr);
+int handle_movn(uint32_t instr);
 int handle_syscall(uint32_t instr);
 int handle_mfhi(uint32_t instr);
 int handle_mthi(uint32_t instr);
@@ -91,6 +106,15 @@ int handle_bgez(uint32_t instr);
 int handle_bltzal(uint32_t instr); 
 int handle_bgezal(uint32_t instr); 
 
+// by SPECIAL2 and SPECIAL3 function code
+int handle_mul(uint32_t instr);
+int handle_clz(uint32_t instr);
+int handle_clo(uint32_t instr);
+int handle_ext(uint32_t instr);
+int handle_ins(uint32_t instr);
+int handle_bshfl(uint32_t instr);
+int handle_rdhwr(uint32_t instr);
+
 // unrecognized codes 
 int handle_unrecognized_opcode(uint32_t instr); 
 int handle_unrecognized_function(uint32_t instr); 
@@ -101,32 +125,72 @@ int handle_unrecognized_target(uint32_t instr);
 */
 
 void process_instruction(void) {
+	// a jump to a misaligned address faults on the fetch
+	if (CURRENT_STATE.PC & 3) {
+		exception_raise(EXC_ADEL, CURRENT_STATE.PC);
+		return;
+	}
+
+	// fetch through the TLB when it is on
+	uint32_t pc = CURRENT_STATE.PC;
+	if (TLB_ENABLED && tlb_translate(&pc, TLB_FETCH)) {
+		return;
+	}
+
 	// read the instr from memory text segment
-	uint32_t raw_instr = mem_read_32(CURRENT_STATE.PC); 
-	printf("Instruction : %d\n", raw_instr);
+	uint32_t raw_instr = mem_read_32(pc); 
 	
 	if(!raw_instr){
 		RUN_BIT = 0;
 		return;
 	}
+
+	RETIRE_RECORD.flags = 0;
+	uint64_t start = COST_ENABLED ? cost_now() : 0;
 	
 	// decode the opcode 
 	int op = decode_opcode(raw_instr);
-	printf("Opcode : %d\n", op);
+	STATS.opcode[op]++;
 	if (op == OPCODE_SPECIAL) {
 		// for special instructions, decode the function value from instruction
 		int func = decode_r_funct(raw_instr);
+		STATS.function[func]++;
 		// dispatch the appropriate instruction handler based on function
+		ACTIVE_HANDLER = HANDLER_FUNCTION(func);
 		(*FUNCTION_DISPATCH[func])(raw_instr);
 	} else if (op == OPCODE_REGIMM) {
 		// for regimm instructions, decode the target value from instruction
 		int target = decode_i_rt(raw_instr);
+		STATS.target[target]++;
 		// dispatch the appropriate instruction handler based on function
+		ACTIVE_HANDLER = HANDLER_TARGET(target);
 		(*TARGET_DISPATCH[target])(raw_instr); 
 	} else {
 		// otherwise, dispatch the appropriate instruction handler based on opcode 
+		ACTIVE_HANDLER = HANDLER_OPCODE(op);
 		(*OPCODE_DISPATCH[op])(raw_instr); 
 	}
+	if (COST_ENABLED) {
+		cost_add(ACTIVE_HANDLER, cost_now() - start);
+	}
+	ACTIVE_HANDLER = HANDLER_NONE;
+
+	// calls and returns open and close trace spans
+	if (TRACE_ENABLED && (RETIRE_RECORD.flags & (RECORD_CALL | RECORD_RETURN))) {
+		if (RETIRE_RECORD.flags & RECORD_CALL) {
+			trace_call(NEXT_STATE.PC);
+		} else {
+			trace_return();
+		}
+	}
+
+	// hand the retired instruction to the analysis consumers
+	if (RETIRE_CONSUMERS) {
+		RETIRE_RECORD.pc = CURRENT_STATE.PC;
+		RETIRE_RECORD.instr = raw_instr;
+		RETIRE_RECORD.next_pc = NEXT_STATE.PC;
+		retire();
+	}
 }
 
 /* ----------------------------------------------------------------------------
@@ -169,6 +233,13 @@ int handle_jal(uint32_t instr) {
 	// place address of instruction after jump in link register 
 	NEXT_STATE.REGS[REG_LINK] = CURRENT_STATE.PC + 4;
 
+	// run a bound library routine natively and continue after the call
+	if (NATIVE_ROUTINES && native_call(NEXT_STATE.PC)) {
+		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		return STATUS_OK;
+	}
+	RETIRE_FLAG(RECORD_CALL);
+
 	return STATUS_OK;
 }
 
@@ -188,9 +259,13 @@ int handle_beq(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] == CURRENT_STATE.REGS[rt]) {
 		// if contents of source and target registers are equal, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset; 
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK;
@@ -212,9 +287,13 @@ int handle_bne(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] != CURRENT_STATE.REGS[rt]) {
 		// if contents of source and taregt registers are not equal, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK; 
@@ -235,9 +314,13 @@ int handle_blez(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] <= 0) {
 		// if contents of source register less than or equal to zero, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4; 
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK; 
@@ -258,9 +341,13 @@ int handle_bgtz(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] > 0) {
 		// if contents of source register greater than zero, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK;
@@ -280,10 +367,14 @@ int handle_addi(uint32_t instr) {
 	int32_t immediate = (int32_t) decode_i_immediate(instr);
 
 	// add contents of source register to immediate to form result
+	// signed overflow raises an exception and leaves the target register unchanged
+	int32_t result;
+	if (__builtin_add_overflow((int32_t) CURRENT_STATE.REGS[rs], immediate, &result)) {
+		return exception_raise(EXC_OV, 0);
+	}
+
 	// store result in target register 
-	// NOTE: addi normally raises exception on overflow (and does not store in this case)
-	// however, this functionality is not implemented here (per lab specs)
-	NEXT_STATE.REGS[rt] = CURRENT_STATE.REGS[rs] + immediate;
+	NEXT_STATE.REGS[rt] = result;
 
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
 
@@ -296,7 +387,6 @@ int handle_addi(uint32_t instr) {
  * Opcode: 9
  */
 int handle_addiu(uint32_t instr) {
-	printf("addiu called\n");
 	// decode source and target registers 
 	int rs = decode_i_rs(instr);
 	int rt = decode_i_rt(instr);
@@ -464,6 +554,45 @@ int handle_lui(uint32_t instr) {
 	return STATUS_OK; 
 }
 
+/*
+ * handle_special2
+ * SPECIAL2 Instructions (mul, clz, clo)
+ * Opcode: 28
+ */
+int handle_special2(uint32_t instr) {
+	// few enough functions that a switch beats another dispatch table
+	switch (decode_r_funct(instr)) {
+	case FUNC2_MUL:
+		return handle_mul(instr);
+	case FUNC2_CLZ:
+		return handle_clz(instr);
+	case FUNC2_CLO:
+		return handle_clo(instr);
+	default:
+		return handle_unrecognized_function(instr);
+	}
+}
+
+/*
+ * handle_special3
+ * SPECIAL3 Instructions (ext, ins, seb, seh, wsbh)
+ * Opcode: 31
+ */
+int handle_special3(uint32_t instr) {
+	switch (decode_r_funct(instr)) {
+	case FUNC3_EXT:
+		return handle_ext(instr);
+	case FUNC3_INS:
+		return handle_ins(instr);
+	case FUNC3_BSHFL:
+		return handle_bshfl(instr);
+	case FUNC3_RDHWR:
+		return handle_rdhwr(instr);
+	default:
+		return handle_unrecognized_function(instr);
+	}
+}
+
 /*
  * handle_lb
  * Load Byte
@@ -480,6 +609,14 @@ int handle_lb(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_MEM(address);
+
 	// load 32 bit word at address, mask off all but low byte 
 	int8_t byte = (int8_t) (mem_read_32(address) & 0x000000FF); 
 
@@ -508,6 +645,19 @@ int handle_lh(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// a halfword access must be naturally aligned
+	if (address & 1) {
+		return exception_raise(EXC_ADEL, address);
+	}
+
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_MEM(address);
+
 	// load 32 bit word at address, mask off all but low halfword
 	int16_t halfword = (int16_t) (mem_read_32(address) & 0x0000FFFF);
 
@@ -535,10 +685,23 @@ int handle_lw(uint32_t instr) {
 
 	// add offet to contents of base register to form address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset; 
+
+	// a word access must be naturally aligned
+	if (address & 3) {
+		return exception_raise(EXC_ADEL, address);
+	}
 		
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
 	// load memory contents at effective address into target register 
 	NEXT_STATE.REGS[rt] = mem_read_32(address); 
 
+	// note the access for the data cache model
+	RETIRE_MEM(address);
+
 	// update the program counter to point to next sequential instr
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4; 
 
@@ -561,6 +724,14 @@ int handle_lbu(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_MEM(address);
+
 	// load 32 bit word at address, mask off all but low byte 
 	uint8_t byte = (uint8_t) (mem_read_32(address) & 0x000000FF); 
 
@@ -589,6 +760,19 @@ int handle_lhu(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// a halfword access must be naturally aligned
+	if (address & 1) {
+		return exception_raise(EXC_ADEL, address);
+	}
+
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_LOAD)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_MEM(address);
+
 	// load 32 bit word at address, mask off all but low halfword
 	uint16_t halfword = (uint16_t) (mem_read_32(address) & 0x0000FFFF);
 
@@ -617,9 +801,24 @@ int handle_sb(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_STORE)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_STORE(address);
+
 	// isolate the low byte of target register 
 	uint32_t byte = (CURRENT_STATE.REGS[rt] & 0x000000FF);
 
+	// device registers take the byte as it is, reading them could have side effects
+	if (MEM_PAGES[address >> PAGE_BITS].attr & PAGE_MMIO) {
+		mmio_write(address, byte);
+		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		return STATUS_OK;
+	}
+
 	// load current data at memory location and mask off low byte
 	uint32_t mem = (mem_read_32(address) & 0xFFFFFF00);
 
@@ -649,9 +848,29 @@ int handle_sh(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// a halfword access must be naturally aligned
+	if (address & 1) {
+		return exception_raise(EXC_ADES, address);
+	}
+
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_STORE)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_STORE(address);
+
 	// isolate the low halfword of target register 
 	uint32_t byte = (CURRENT_STATE.REGS[rt] & 0x0000FFFF);
 
+	// device registers take the halfword as it is, reading them could have side effects
+	if (MEM_PAGES[address >> PAGE_BITS].attr & PAGE_MMIO) {
+		mmio_write(address, byte);
+		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		return STATUS_OK;
+	}
+
 	// load current data at memory location and mask off low halfword
 	uint32_t mem = (mem_read_32(address) & 0xFFFF0000);
 
@@ -681,6 +900,19 @@ int handle_sw(uint32_t instr) {
 	// combine contents of base register and offset to form virtual address
 	uint32_t address = CURRENT_STATE.REGS[base] + offset;
 
+	// a word access must be naturally aligned
+	if (address & 3) {
+		return exception_raise(EXC_ADES, address);
+	}
+
+	// translate to a physical address, which may fault
+	if (TLB_ENABLED && tlb_translate(&address, TLB_STORE)) {
+		return STATUS_ERR;
+	}
+
+	// note the access for the data cache model
+	RETIRE_STORE(address);
+
 	// store contents of target register at memory location specified by address
 	mem_write_32(address, CURRENT_STATE.REGS[rt]);
 
@@ -726,9 +958,15 @@ int handle_srl(uint32_t instr) {
 	int rd = decode_r_rd(instr);
 	int sa = decode_r_shamt(instr);
 
-	// contents of target register shifted left by sa bits
-	// store result in destination regiter
-	NEXT_STATE.REGS[rd] = (CURRENT_STATE.REGS[rt] >> sa);
+	if (decode_r_rs(instr) == FUNC_ROTATE) {
+		// rotr (MIPS32r2): bits shifted out wrap around, one host rotate
+		uint32_t value = CURRENT_STATE.REGS[rt];
+		NEXT_STATE.REGS[rd] = (value >> sa) | (value << ((32 - sa) & 31));
+	} else {
+		// contents of target register shifted left by sa bits
+		// store result in destination regiter
+		NEXT_STATE.REGS[rd] = (CURRENT_STATE.REGS[rt] >> sa);
+	}
 
 	// update the program counter to point to next sequential instr
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
@@ -796,8 +1034,14 @@ int handle_srlv(uint32_t instr) {
 	// shift amount determined by low order five bits of source register 
 	int sa = (CURRENT_STATE.REGS[rs] & 0x000001F);
 
-	// store result of left shift of target register content in destination register
-	NEXT_STATE.REGS[rd] = (CURRENT_STATE.REGS[rt] >> sa); 
+	if (decode_r_shamt(instr) == FUNC_ROTATE) {
+		// rotrv (MIPS32r2): bits shifted out wrap around, one host rotate
+		uint32_t value = CURRENT_STATE.REGS[rt];
+		NEXT_STATE.REGS[rd] = (value >> sa) | (value << ((32 - sa) & 31));
+	} else {
+		// store result of left shift of target register content in destination register
+		NEXT_STATE.REGS[rd] = (CURRENT_STATE.REGS[rt] >> sa); 
+	}
 
 	// update the program counter to point to next sequential instr
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
@@ -843,6 +1087,11 @@ int handle_jr(uint32_t instr) {
 	// unconditionally jump to address stored in source register 
 	NEXT_STATE.PC = CURRENT_STATE.REGS[rs]; 
 
+	// jumps through the link register are subroutine returns
+	if (rs == REG_LINK) {
+		RETIRE_FLAG(RECORD_RETURN);
+	}
+
 	return STATUS_OK;
 }
 
@@ -861,23 +1110,82 @@ int handle_jalr(uint32_t instr) {
 	// and that, if this is the case, the link register (r31) is default 
 	NEXT_STATE.REGS[rd] = CURRENT_STATE.PC + 4;
 
+	// run a bound library routine natively and continue after the call
+	if (NATIVE_ROUTINES && native_call(CURRENT_STATE.REGS[rs])) {
+		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		return STATUS_OK;
+	}
+	RETIRE_FLAG(RECORD_CALL);
+
 	// unconditionally jump to address stored in source register 
 	NEXT_STATE.PC = CURRENT_STATE.REGS[rs];
 
 	return STATUS_OK;  
 }
 
+/*
+ * handle_movz
+ * Move Conditional on Zero (MIPS32r2)
+ * Function: 10
+ */
+int handle_movz(uint32_t instr) {
+	// decode source register, target register, and destination register
+	int rs = decode_r_rs(instr);
+	int rt = decode_r_rt(instr);
+	int rd = decode_r_rd(instr);
+
+	// copy source register to destination register if target register is zero
+	if (CURRENT_STATE.REGS[rt] == 0) {
+		NEXT_STATE.REGS[rd] = CURRENT_STATE.REGS[rs];
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_movn
+ * Move Conditional on Not Zero (MIPS32r2)
+ * Function: 11
+ */
+int handle_movn(uint32_t instr) {
+	// decode source register, target register, and destination register
+	int rs = decode_r_rs(instr);
+	int rt = decode_r_rt(instr);
+	int rd = decode_r_rd(instr);
+
+	// copy source register to destination register if target register is not zero
+	if (CURRENT_STATE.REGS[rt] != 0) {
+		NEXT_STATE.REGS[rd] = CURRENT_STATE.REGS[rs];
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
 /*
  * handle_syscall
  * System Call
  * Function: 12
  */
 int handle_syscall(uint32_t instr) {
-	if (CURRENT_STATE.REGS[REG_SYSCALL] == 0x0000000A) {
-		// if syscall register has value 0x0A, halt 
-		// otherwise, instruction has no effect
-		RUN_BIT = 0; 
-	} 
+	uint32_t code = CURRENT_STATE.REGS[REG_SYSCALL];
+
+	TRACE_SYSCALL(code, CURRENT_STATE.REGS[REG_ARG0]);
+
+	if (code == SYSCALL_PHASE_BEGIN || code == SYSCALL_PHASE_END) {
+		// phase markers only matter to the trace
+		if (TRACE_ENABLED) {
+			trace_phase(code == SYSCALL_PHASE_BEGIN, CURRENT_STATE.REGS[REG_ARG0]);
+		}
+	} else {
+		// console, heap, file and exit services; unknown codes have no effect
+		syscall_emulate(code);
+	}
 	
 	// increment program counter to next sequential instr
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
@@ -1088,7 +1396,12 @@ int handle_add(uint32_t instr) {
 	int32_t target = (int32_t) CURRENT_STATE.REGS[rt];
 
 	// contents of source and target registers added to form result 
-	NEXT_STATE.REGS[rd] = source + target; 
+	// signed overflow raises an exception and leaves the destination unchanged
+	int32_t result;
+	if (__builtin_add_overflow(source, target, &result)) {
+		return exception_raise(EXC_OV, 0);
+	}
+	NEXT_STATE.REGS[rd] = result; 
 
 	// update the program counter to point to next sequential instr
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
@@ -1135,7 +1448,12 @@ int handle_sub(uint32_t instr) {
 	int32_t target = (int32_t) CURRENT_STATE.REGS[rt];
 
 	// contents of target subtracted from contents of soucre to form result  
-	NEXT_STATE.REGS[rd] = source - target;
+	// signed overflow raises an exception and leaves the destination unchanged
+	int32_t result;
+	if (__builtin_sub_overflow(source, target, &result)) {
+		return exception_raise(EXC_OV, 0);
+	}
+	NEXT_STATE.REGS[rd] = result;
 
 	// update the program counter to point to next sequential instr 
 	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
@@ -1328,9 +1646,13 @@ int handle_bltz(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] < 0) {
 		// if contents of source register less than zero, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK; 
@@ -1351,9 +1673,13 @@ int handle_bgez(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] >= 0) {
 		// if contents of source register greater than or equal to zero, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK; 
@@ -1377,9 +1703,14 @@ int handle_bltzal(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] < 0) {
 		// if contents of source register less than zero, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
+		RETIRE_FLAG(RECORD_CALL);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK; 
@@ -1403,16 +1734,204 @@ int handle_bgezal(uint32_t instr) {
 	if (CURRENT_STATE.REGS[rs] >= 0) {
 		// if contents of source register greater than or equal to zero, branch is taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + offset;
+		STATS.branch_taken++;
+		RETIRE_FLAG(RECORD_BRANCH | RECORD_TAKEN);
+		RETIRE_FLAG(RECORD_CALL);
 	} else {
 		// otherwise, not taken
 		NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+		STATS.branch_not_taken++;
+		RETIRE_FLAG(RECORD_BRANCH);
 	}
 
 	return STATUS_OK; 
 }
 
+/* ----------------------------------------------------------------------------
+	Instruction Handlers, by SPECIAL2 and SPECIAL3 Function (MIPS32 Release 2)
+*/
+
+/*
+ * handle_mul
+ * Multiply Word to Register
+ * SPECIAL2 Function: 2
+ */
+int handle_mul(uint32_t instr) {
+	// decode source register, target register, and destination register
+	int rs = decode_r_rs(instr);
+	int rt = decode_r_rt(instr);
+	int rd = decode_r_rd(instr);
+
+	// low 32 bits of the product, HI and LO are left alone
+	NEXT_STATE.REGS[rd] = CURRENT_STATE.REGS[rs] * CURRENT_STATE.REGS[rt];
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_clz
+ * Count Leading Zeros in Word
+ * SPECIAL2 Function: 32
+ */
+int handle_clz(uint32_t instr) {
+	// decode source register and destination register
+	int rs = decode_r_rs(instr);
+	int rd = decode_r_rd(instr);
+
+	// host clz is undefined for zero, which has 32 leading zeros
+	uint32_t value = CURRENT_STATE.REGS[rs];
+	NEXT_STATE.REGS[rd] = value ? __builtin_clz(value) : 32;
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_clo
+ * Count Leading Ones in Word
+ * SPECIAL2 Function: 33
+ */
+int handle_clo(uint32_t instr) {
+	// decode source register and destination register
+	int rs = decode_r_rs(instr);
+	int rd = decode_r_rd(instr);
+
+	// leading ones are the leading zeros of the complement
+	uint32_t value = ~CURRENT_STATE.REGS[rs];
+	NEXT_STATE.REGS[rd] = value ? __builtin_clz(value) : 32;
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_ext
+ * Extract Bit Field
+ * SPECIAL3 Function: 0
+ */
+int handle_ext(uint32_t instr) {
+	// decode source and target registers, field position and size
+	// the rd field holds the size minus one, the shamt field the position
+	int rs   = decode_r_rs(instr);
+	int rt   = decode_r_rt(instr);
+	int size = decode_r_rd(instr) + 1;
+	int pos  = decode_r_shamt(instr);
+
+	// right-justify the field and clear the bits above it
+	uint32_t mask = size == 32 ? 0xFFFFFFFF : (1u << size) - 1;
+	NEXT_STATE.REGS[rt] = (CURRENT_STATE.REGS[rs] >> pos) & mask;
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_ins
+ * Insert Bit Field
+ * SPECIAL3 Function: 4
+ */
+int handle_ins(uint32_t instr) {
+	// decode source and target registers, field position and size
+	// the rd field holds the most significant bit of the field
+	int rs   = decode_r_rs(instr);
+	int rt   = decode_r_rt(instr);
+	int pos  = decode_r_shamt(instr);
+	int size = decode_r_rd(instr) - pos + 1;
+
+	// fields ending below their start are unpredictable, leave rt alone
+	if (size > 0) {
+		uint32_t mask = (size == 32 ? 0xFFFFFFFF : (1u << size) - 1) << pos;
+		NEXT_STATE.REGS[rt] = (CURRENT_STATE.REGS[rt] & ~mask) |
+			((CURRENT_STATE.REGS[rs] << pos) & mask);
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_bshfl
+ * Byte Shuffle (seb, seh, wsbh; operation in the shamt field)
+ * SPECIAL3 Function: 32
+ */
+int handle_bshfl(uint32_t instr) {
+	// decode target register and destination register
+	int rt = decode_r_rt(instr);
+	int rd = decode_r_rd(instr);
+	uint32_t value = CURRENT_STATE.REGS[rt];
+
+	switch (decode_r_shamt(instr)) {
+	case BSHFL_SEB:
+		// sign-extend the low byte
+		NEXT_STATE.REGS[rd] = (int32_t) (int8_t) value;
+		break;
+	case BSHFL_SEH:
+		// sign-extend the low halfword
+		NEXT_STATE.REGS[rd] = (int32_t) (int16_t) value;
+		break;
+	case BSHFL_WSBH:
+		// swap bytes within each halfword: a byte swap with the halves rotated back
+		value = __builtin_bswap32(value);
+		NEXT_STATE.REGS[rd] = (value >> 16) | (value << 16);
+		break;
+	default:
+		return handle_unrecognized_function(instr);
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
+/*
+ * handle_rdhwr
+ * Read Hardware Register (MIPS32r2)
+ * SPECIAL3 Function: 59
+ */
+int handle_rdhwr(uint32_t instr) {
+	// decode target register and hardware register number
+	int rt = decode_r_rt(instr);
+
+	switch (decode_r_rd(instr)) {
+	case HWR_CPUNUM:
+		NEXT_STATE.REGS[rt] = 0;
+		break;
+	case HWR_SYNCI_STEP:
+		// there are no caches for synci to manage
+		NEXT_STATE.REGS[rt] = 0;
+		break;
+	case HWR_CC:
+		// the cycle counter is CP0 Count
+		NEXT_STATE.REGS[rt] = cp0_count();
+		break;
+	case HWR_CCRES:
+		NEXT_STATE.REGS[rt] = 1;
+		break;
+	default:
+		return handle_unrecognized_function(instr);
+	}
+
+	// update the program counter to point to next sequential instr
+	NEXT_STATE.PC = CURRENT_STATE.PC + 4;
+
+	return STATUS_OK;
+}
+
 /* ----------------------------------------------------------------------------
 	Unrecognized Instruction Handlers (Opcode and Function)
+	These raise a reserved instruction exception.
 */
 
 /*
@@ -1421,8 +1940,7 @@ int handle_bgezal(uint32_t instr) {
  * Opcode: any undefined opcode 
  */
 int handle_unrecognized_opcode(uint32_t instr) {
-	fprintf(stderr, "ERROR: unrecognzied opcode\n");
-	return STATUS_ERR;
+	return exception_raise(EXC_RI, 0);
 }
 
 /*
@@ -1431,8 +1949,7 @@ int handle_unrecognized_opcode(uint32_t instr) {
  * Opcode: any undefined function 
  */
 int handle_unrecognized_function(uint32_t instr) {
-	fprintf(stderr, "ERROR: unrecognzied function\n");
-	return STATUS_ERR;
+	return exception_raise(EXC_RI, 0);
 }
 
 /*
@@ -1441,8 +1958,7 @@ int handle_unrecognized_function(uint32_t instr) {
  * Opcode: any undefined target 
  */
 int handle_unrecognized_target(uint32_t instr) {
-	fprintf(stderr, "ERROR: unrecognzied target\n");
-	return STATUS_ERR;
+	return exception_raise(EXC_RI, 0);
 }
 
 /* ----------------------------------------------------------------------------
@@ -1473,6 +1989,10 @@ void init_opcode_dispatch(void) {
 	OPCODE_DISPATCH[OPCODE_ORI]   = handle_ori; 
 	OPCODE_DISPATCH[OPCODE_XORI]  = handle_xori;
 	OPCODE_DISPATCH[OPCODE_LUI]   = handle_lui;
+	OPCODE_DISPATCH[OPCODE_COP0]  = handle_cop0;
+	OPCODE_DISPATCH[OPCODE_COP1]  = handle_cop1;
+	OPCODE_DISPATCH[OPCODE_SPECIAL2] = handle_special2;
+	OPCODE_DISPATCH[OPCODE_SPECIAL3] = handle_special3;
 	OPCODE_DISPATCH[OPCODE_LB]    = handle_lb;
 	OPCODE_DISPATCH[OPCODE_LH]    = handle_lh;
 	OPCODE_DISPATCH[OPCODE_LW]    = handle_lw;
@@ -1482,6 +2002,10 @@ void init_opcode_dispatch(void) {
 	OPCODE_DISPATCH[OPCODE_SB]    = handle_sb;
 	OPCODE_DISPATCH[OPCODE_SH]    = handle_sh;
 	OPCODE_DISPATCH[OPCODE_SW]    = handle_sw;
+	OPCODE_DISPATCH[OPCODE_LWC1]  = handle_lwc1;
+	OPCODE_DISPATCH[OPCODE_LDC1]  = handle_ldc1;
+	OPCODE_DISPATCH[OPCODE_SWC1]  = handle_swc1;
+	OPCODE_DISPATCH[OPCODE_SDC1]  = handle_sdc1;
 }
 
 void init_function_dispatch(void) {
@@ -1502,6 +2026,8 @@ void init_function_dispatch(void) {
 	FUNCTION_DISPATCH[FUNC_SRAV]    = handle_srav;
 	FUNCTION_DISPATCH[FUNC_JR]      = handle_jr;
 	FUNCTION_DISPATCH[FUNC_JALR]    = handle_jalr;
+	FUNCTION_DISPATCH[FUNC_MOVZ]    = handle_movz;
+	FUNCTION_DISPATCH[FUNC_MOVN]    = handle_movn;
 	FUNCTION_DISPATCH[FUNC_SYSCALL] = handle_syscall; 
 	FUNCTION_DISPATCH[FUNC_MFHI]    = handle_mfhi;
 	FUNCTION_DISPATCH[FUNC_MTHI]    = handle_mthi;
@@ -0,0 +1,436 @@
+/*
+ * simt.c
+ * Lockstep (SIMT) execution of many instances of one program.
+ *
+ * A warp of SIMT_LANES instances shares one instruction stream. Register
+ * files are stored structure-of-arrays, so each register is a lane_vec and
+ * ALU instructions become single vector operations across all instances.
+ * Every step issues the instruction at the lowest PC among running lanes;
+ * lanes at other PCs (after diverging at a branch) are masked off until
+ * they reconverge. Instructions without a vector handler run lane by lane
+ * through the scalar handlers.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "simt.h"
+#include "shell.h"
+#include "decode.h"
+#include "stats.h"
+
+/* ----------------------------------------------------------------------------
+	Warp State
+*/
+
+typedef struct Warp_Struct {
+	lane_vec REGS[MIPS_REGS];  // register file, one vector per register
+	lane_vec HI;
+	lane_vec LO;
+	lane_vec PC;               // program counter of each lane
+	lane_vec live;             // all ones for lanes still running
+	lane_vec count;            // instructions retired by each lane
+	lane_vec mask;             // all ones for lanes issuing this step
+
+	// private data, stack and kdata regions for each lane (text is shared)
+	uint8_t *mem[SIMT_LANES][MEM_NREGIONS];
+} Warp;
+
+// merge val into dst for the lanes selected by mask m
+#define LANE_MERGE(dst, val, m) ((dst) = ((dst) & ~(m)) | ((val) & (m)))
+
+// regions every lane gets its own copy of
+#define LANE_PRIVATE(i) (MEM_REGIONS[i].start != MEM_TEXT_START && \
+                         MEM_REGIONS[i].start != MEM_KTEXT_START)
+
+// batch statistics
+static uint64_t vector_issues;
+static uint64_t scalar_issues;
+static uint64_t active_lanes;
+
+/*
+ * lane_count
+ * Number of lanes set in mask m.
+ */
+static int lane_count(const lane_vec *m) {
+	int n = 0;
+	for (int lane = 0; lane < SIMT_LANES; lane++) {
+		n += (*m)[lane] & 1;
+	}
+	return n;
+}
+
+/*
+ * lane_count_branches
+ * Update branch counters for a vector branch issued on the warp's mask.
+ */
+static void lane_count_branches(Warp *w, const lane_vec *taken) {
+	lane_vec m = *taken & w->mask;
+	int n = lane_count(&m);
+	STATS.branch_taken     += n;
+	STATS.branch_not_taken += lane_count(&w->mask) - n;
+}
+
+/* ----------------------------------------------------------------------------
+	Vector Instruction Handlers
+*/
+
+typedef void (*simt_handler)(Warp *w, uint32_t instr);
+
+// vector handler tables, NULL entries fall back to the scalar handlers
+static simt_handler VEC_OPCODE_DISPATCH[DISPATCH_SIZE];
+static simt_handler VEC_FUNCTION_DISPATCH[DISPATCH_SIZE];
+
+static void vec_beq(Warp *w, uint32_t instr) {
+	int rs = decode_i_rs(instr);
+	int rt = decode_i_rt(instr);
+	int32_t offset = (int32_t) (decode_i_immediate(instr) << 2);
+
+	// taken lanes move to the target, the rest fall through
+	lane_vec taken = (lane_vec) (w->REGS[rs] == w->REGS[rt]);
+	lane_vec next  = ((w->PC + offset) & taken) | ((w->PC + 4) & ~taken);
+	LANE_MERGE(w->PC, next, w->mask);
+	lane_count_branches(w, &taken);
+}
+
+static void vec_bne(Warp *w, uint32_t instr) {
+	int rs = decode_i_rs(instr);
+	int rt = decode_i_rt(instr);
+	int32_t offset = (int32_t) (decode_i_immediate(instr) << 2);
+
+	lane_vec taken = (lane_vec) (w->REGS[rs] != w->REGS[rt]);
+	lane_vec next  = ((w->PC + offset) & taken) | ((w->PC + 4) & ~taken);
+	LANE_MERGE(w->PC, next, w->mask);
+	lane_count_branches(w, &taken);
+}
+
+// I-type ALU instructions share decode and PC update
+#define VEC_I_TYPE(name, expr)                                     \
+static void vec_##name(Warp *w, uint32_t instr) {      \
+	int rs = decode_i_rs(instr);                                   \
+	int rt = decode_i_rt(instr);                                   \
+	int32_t immediate = (int32_t) decode_i_immediate(instr);       \
+	(void) rs; (void) immediate;                                   \
+	LANE_MERGE(w->REGS[rt], (expr), w->mask);                      \
+	w->PC += w->mask & 4;                                          \
+}
+
+VEC_I_TYPE(addiu, w->REGS[rs] + immediate)
+VEC_I_TYPE(slti,  (lane_vec) ((lane_svec) w->REGS[rs] < immediate) & 1)
+VEC_I_TYPE(sltiu, (lane_vec) (w->REGS[rs] < (uint32_t) immediate) & 1)
+VEC_I_TYPE(andi,  w->REGS[rs] & (uint32_t) immediate)
+VEC_I_TYPE(ori,   w->REGS[rs] | (uint32_t) immediate)
+VEC_I_TYPE(xori,  w->REGS[rs] ^ (uint32_t) immediate)
+
+static void vec_lui(Warp *w, uint32_t instr) {
+	int rt = decode_i_rt(instr);
+	int32_t immediate = (int32_t) ((decode_i_immediate(instr) << 16) & 0xFFFF0000);
+
+	// broadcast the immediate to every lane
+	lane_vec value = (lane_vec) {} + (uint32_t) immediate;
+	LANE_MERGE(w->REGS[rt], value, w->mask);
+	w->PC += w->mask & 4;
+}
+
+// R-type ALU instructions share decode and PC update
+#define VEC_R_TYPE(name, expr)                                     \
+static void vec_##name(Warp *w, uint32_t instr) {      \
+	int rs = decode_r_rs(instr);                                   \
+	int rt = decode_r_rt(instr);                                   \
+	int rd = decode_r_rd(instr);                                   \
+	int sa = decode_r_shamt(instr);                                \
+	(void) rs; (void) sa;                                          \
+	LANE_MERGE(w->REGS[rd], (expr), w->mask);                      \
+	w->PC += w->mask & 4;                                          \
+}
+
+VEC_R_TYPE(sll,  w->REGS[rt] << sa)
+VEC_R_TYPE(srl,  w->REGS[rt] >> sa)
+VEC_R_TYPE(sllv, w->REGS[rt] << (w->REGS[rs] & 0x1F))
+VEC_R_TYPE(srlv, w->REGS[rt] >> (w->REGS[rs] & 0x1F))
+VEC_R_TYPE(addu, w->REGS[rs] + w->REGS[rt])
+VEC_R_TYPE(subu, w->REGS[rs] - w->REGS[rt])
+VEC_R_TYPE(and,  w->REGS[rs] & w->REGS[rt])
+VEC_R_TYPE(or,   w->REGS[rs] | w->REGS[rt])
+VEC_R_TYPE(xor,  w->REGS[rs] ^ w->REGS[rt])
+VEC_R_TYPE(nor,  ~(w->REGS[rs] | w->REGS[rt]))
+VEC_R_TYPE(slt,  (lane_vec) ((lane_svec) w->REGS[rs] < (lane_svec) w->REGS[rt]) & 1)
+VEC_R_TYPE(sltu, (lane_vec) (w->REGS[rs] < w->REGS[rt]) & 1)
+
+static void init_vector_dispatch(void) {
+	memset(VEC_OPCODE_DISPATCH, 0, sizeof(VEC_OPCODE_DISPATCH));
+	memset(VEC_FUNCTION_DISPATCH, 0, sizeof(VEC_FUNCTION_DISPATCH));
+
+	// instruction handlers, in increasing order of opcode value
+	VEC_OPCODE_DISPATCH[OPCODE_BEQ]   = vec_beq;
+	VEC_OPCODE_DISPATCH[OPCODE_BNE]   = vec_bne;
+	VEC_OPCODE_DISPATCH[OPCODE_ADDIU] = vec_addiu;
+	VEC_OPCODE_DISPATCH[OPCODE_SLTI]  = vec_slti;
+	VEC_OPCODE_DISPATCH[OPCODE_SLTIU] = vec_sltiu;
+	VEC_OPCODE_DISPATCH[OPCODE_ANDI]  = vec_andi;
+	VEC_OPCODE_DISPATCH[OPCODE_ORI]   = vec_ori;
+	VEC_OPCODE_DISPATCH[OPCODE_XORI]  = vec_xori;
+	VEC_OPCODE_DISPATCH[OPCODE_LUI]   = vec_lui;
+
+	// instruction handlers, in increasing order of function code value
+	// (add and sub go through the scalar handlers for their overflow semantics)
+	VEC_FUNCTION_DISPATCH[FUNC_SLL]   = vec_sll;
+	VEC_FUNCTION_DISPATCH[FUNC_SRL]   = vec_srl;
+	VEC_FUNCTION_DISPATCH[FUNC_SLLV]  = vec_sllv;
+	VEC_FUNCTION_DISPATCH[FUNC_SRLV]  = vec_srlv;
+	VEC_FUNCTION_DISPATCH[FUNC_ADDU]  = vec_addu;
+	VEC_FUNCTION_DISPATCH[FUNC_SUBU]  = vec_subu;
+	VEC_FUNCTION_DISPATCH[FUNC_AND]   = vec_and;
+	VEC_FUNCTION_DISPATCH[FUNC_OR]    = vec_or;
+	VEC_FUNCTION_DISPATCH[FUNC_XOR]   = vec_xor;
+	VEC_FUNCTION_DISPATCH[FUNC_NOR]   = vec_nor;
+	VEC_FUNCTION_DISPATCH[FUNC_SLT]   = vec_slt;
+	VEC_FUNCTION_DISPATCH[FUNC_SLTU]  = vec_sltu;
+}
+
+/* ----------------------------------------------------------------------------
+	Scalar Fallback
+*/
+
+/*
+ * simt_scalar_step
+ * Execute the current instruction for a single lane through the scalar
+ * handlers, by moving the lane's state into the scalar machine and back.
+ */
+static void simt_scalar_step(Warp *w, int lane) {
+	int r, i;
+
+	for (r = 0; r < MIPS_REGS; r++) {
+		CURRENT_STATE.REGS[r] = w->REGS[r][lane];
+	}
+	CURRENT_STATE.HI = w->HI[lane];
+	CURRENT_STATE.LO = w->LO[lane];
+	CURRENT_STATE.PC = w->PC[lane];
+	NEXT_STATE = CURRENT_STATE;
+
+	for (i = 0; i < MEM_NREGIONS; i++) {
+		if (LANE_PRIVATE(i)) {
+			MEM_REGIONS[i].mem = w->mem[lane][i];
+			mem_map_region(i);
+		}
+	}
+
+	RUN_BIT = TRUE;
+	process_instruction();
+
+	for (r = 0; r < MIPS_REGS; r++) {
+		w->REGS[r][lane] = NEXT_STATE.REGS[r];
+	}
+	w->HI[lane] = NEXT_STATE.HI;
+	w->LO[lane] = NEXT_STATE.LO;
+	w->PC[lane] = NEXT_STATE.PC;
+
+	if (!RUN_BIT) {
+		w->live[lane] = 0;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Warp Execution
+*/
+
+/*
+ * simt_warp_run
+ * Run all lanes of the warp to completion.
+ */
+static void simt_warp_run(Warp *w) {
+	for (;;) {
+		// schedule the lowest PC among running lanes, lanes that diverged
+		// ahead wait for the others to reach them
+		uint32_t pc = UINT32_MAX;
+		int lane, running = 0;
+		for (lane = 0; lane < SIMT_LANES; lane++) {
+			if (w->live[lane] && w->PC[lane] < pc) {
+				pc = w->PC[lane];
+			}
+			running |= w->live[lane];
+		}
+		if (!running) {
+			break;
+		}
+
+		lane_vec m = (lane_vec) (w->PC == pc) & w->live;
+		w->mask   = m;
+		w->count += m & 1;
+
+		// the text segment is shared by all lanes
+		uint32_t instr = mem_read_32(pc);
+		if (!instr) {
+			w->live &= ~m;
+			continue;
+		}
+
+		int op = decode_opcode(instr);
+		simt_handler handler = NULL;
+		if (op == OPCODE_SPECIAL) {
+			int func = decode_r_funct(instr);
+			handler = VEC_FUNCTION_DISPATCH[func];
+
+			// rotr and rotrv share the srl and srlv function codes
+			if ((func == FUNC_SRL && decode_r_rs(instr) == FUNC_ROTATE) ||
+					(func == FUNC_SRLV && decode_r_shamt(instr) == FUNC_ROTATE)) {
+				handler = NULL;
+			}
+		} else if (op != OPCODE_REGIMM) {
+			handler = VEC_OPCODE_DISPATCH[op];
+		}
+
+		int issued = lane_count(&m);
+		if (handler) {
+			(*handler)(w, instr);
+			vector_issues++;
+
+			// scalar fallback counts through process_instruction
+			STATS.opcode[op] += issued;
+			if (op == OPCODE_SPECIAL) {
+				STATS.function[decode_r_funct(instr)] += issued;
+			}
+		} else {
+			for (lane = 0; lane < SIMT_LANES; lane++) {
+				if (m[lane]) {
+					simt_scalar_step(w, lane);
+				}
+			}
+			scalar_issues++;
+		}
+		active_lanes += issued;
+	}
+}
+
+/* ----------------------------------------------------------------------------
+	Batch Driver
+*/
+
+/*
+ * parse_instance
+ * Apply reg=value pairs from one input line to lane of the warp.
+ */
+static void parse_instance(Warp *w, int lane, char *line) {
+	char *tok;
+
+	for (tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+		char *eq = strchr(tok, '=');
+		if (eq == NULL) {
+			continue;
+		}
+		*eq = '\0';
+
+		uint32_t value = (uint32_t) strtoul(eq + 1, NULL, 0);
+		if (!strcasecmp(tok, "hi")) {
+			w->HI[lane] = value;
+		} else if (!strcasecmp(tok, "lo")) {
+			w->LO[lane] = value;
+		} else {
+			int reg = atoi(tok[0] == 'r' || tok[0] == 'R' ? tok + 1 : tok);
+			if (reg >= 0 && reg < MIPS_REGS) {
+				w->REGS[reg][lane] = value;
+			}
+		}
+	}
+}
+
+/*
+ * warp_dump
+ * Print final state of each used lane.
+ */
+static void warp_dump(Warp *w, int first, int used, FILE *out) {
+	for (int lane = 0; lane < used; lane++) {
+		fprintf(out, "Instance %d : Count %u PC 0x%08x HI 0x%08x LO 0x%08x\n",
+			first + lane, w->count[lane], w->PC[lane], w->HI[lane], w->LO[lane]);
+		for (int r = 0; r < MIPS_REGS; r++) {
+			fprintf(out, "%sR%d: 0x%08x%s", (r % 8) ? " " : "  ", r,
+				w->REGS[r][lane], (r % 8 == 7) ? "\n" : "");
+		}
+	}
+}
+
+int simt_run(const char *inputs_filename, FILE *out) {
+	FILE *inputs;
+	char line[1024];
+	int instances = 0;
+	int i, lane;
+
+	if ((inputs = fopen(inputs_filename, "r")) == NULL) {
+		return -1;
+	}
+
+	init_vector_dispatch();
+
+	// every instance starts from the loaded machine state
+	CPU_State initial = CURRENT_STATE;
+
+	uint8_t *scalar_mem[MEM_NREGIONS];
+	for (i = 0; i < MEM_NREGIONS; i++) {
+		scalar_mem[i] = MEM_REGIONS[i].mem;
+	}
+
+	Warp *w = aligned_alloc(64, sizeof(Warp));
+	int more = 1;
+	while (more) {
+		memset(w, 0, sizeof(Warp));
+
+		int used = 0;
+		while (used < SIMT_LANES && (more = (fgets(line, sizeof(line), inputs) != NULL))) {
+			if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') {
+				continue;
+			}
+
+			for (int r = 0; r < MIPS_REGS; r++) {
+				w->REGS[r][used] = initial.REGS[r];
+			}
+			w->HI[used] = initial.HI;
+			w->LO[used] = initial.LO;
+			w->PC[used] = initial.PC;
+			w->live[used] = ~0U;
+			parse_instance(w, used, line);
+
+			for (i = 0; i < MEM_NREGIONS; i++) {
+				w->mem[used][i] = LANE_PRIVATE(i) ? calloc(MEM_REGIONS[i].size, 1) : scalar_mem[i];
+			}
+			used++;
+		}
+
+		if (used == 0) {
+			break;
+		}
+
+		simt_warp_run(w);
+		warp_dump(w, instances, used, out);
+		instances += used;
+
+		for (lane = 0; lane < used; lane++) {
+			for (i = 0; i < MEM_NREGIONS; i++) {
+				if (LANE_PRIVATE(i)) {
+					free(w->mem[lane][i]);
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < MEM_NREGIONS; i++) {
+		MEM_REGIONS[i].mem = scalar_mem[i];
+		mem_map_region(i);
+	}
+	free(w);
+	fclose(inputs);
+
+	uint64_t issues = vector_issues + scalar_issues;
+	fprintf(out, "\nSIMT batch: %d instances, %d lanes per warp\n", instances, SIMT_LANES);
+	fprintf(out, "Issued    : %llu (%llu vector, %llu scalar fallback)\n",
+		(unsigned long long) issues, (unsigned long long) vector_issues,
+		(unsigned long long) scalar_issues);
+	fprintf(out, "Lane util : %.1f%%\n",
+		issues ? 100.0 * active_lanes / ((double) issues * SIMT_LANES) : 0.0);
+
+	return instances;
+}
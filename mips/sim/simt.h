@@ -0,0 +1,30 @@
+/*
+ * simt.h
+ * Lockstep (SIMT) execution of many instances of one program.
+ */
+
+#ifndef __SIMT_H
+#define __SIMT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// instances executed together, 16 x 32-bit lanes fill one 512-bit vector
+// build with -mavx2 or -mavx512f to have lane operations use those units
+#define SIMT_LANES 16
+
+// lane-parallel register value, one 32-bit element per instance
+typedef uint32_t lane_vec  __attribute__ ((vector_size (SIMT_LANES * 4)));
+typedef int32_t  lane_svec __attribute__ ((vector_size (SIMT_LANES * 4)));
+
+/*
+ * simt_run
+ * Run the loaded program once per line of the inputs file, SIMT_LANES
+ * instances at a time in lockstep. Each input line holds the initial
+ * register values of one instance as reg=value pairs (e.g. "4=10 5=0x20").
+ * Final register state of every instance is printed to out.
+ * Returns number of instances run, or -1 if the inputs file can't be read.
+ */
+int simt_run(const char *inputs_filename, FILE *out);
+
+#endif // __SIMT_H
@@ -0,0 +1,145 @@
+/*
+ * simtop.c
+ * Monitor for the live statistics a simulator run publishes with -L.
+ *
+ * Usage: simtop [-i ms] [-1] [-u] name
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "live.h"
+
+static const char *CLASS_NAMES[LIVE_CLASSES] = {
+	"alu", "load", "store", "branch", "jump", "mul/div", "syscall", "other"
+};
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static void usage(const char *program) {
+	fprintf(stderr, "Usage: %s [-i ms] [-1] [-u] name\n", program);
+	fprintf(stderr, "  -i ms  refresh every ms milliseconds (default 1000)\n");
+	fprintf(stderr, "  -1     print one snapshot and exit\n");
+	fprintf(stderr, "  -u     remove the segment once the run has halted\n");
+	exit(1);
+}
+
+static void sleep_ms(int ms) {
+	struct timespec delay = { ms / 1000, (ms % 1000) * 1000000L };
+	nanosleep(&delay, NULL);
+}
+
+/*
+ * attach
+ * Map segment name read-only, waiting for the simulator to create it.
+ */
+static const LiveStats *attach(const char *name) {
+	const LiveStats *live;
+	int fd;
+
+	while ((fd = shm_open(name, O_RDONLY, 0)) < 0) {
+		sleep_ms(100);
+	}
+	live = mmap(NULL, sizeof(LiveStats), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (live == MAP_FAILED) {
+		return NULL;
+	}
+
+	while (live->magic != LIVE_MAGIC) {
+		sleep_ms(10);
+	}
+	atomic_thread_fence(memory_order_acquire);
+	return live->version == LIVE_VERSION ? live : NULL;
+}
+
+static void display(FILE *out, const LiveStats *stats, int running, int refresh) {
+	uint64_t total = 0;
+
+	for (int i = 0; i < LIVE_CLASSES; i++) {
+		total += stats->classes[i];
+	}
+
+	if (refresh) {
+		fprintf(out, "\033[H\033[J");
+	}
+	fprintf(out, "%s (pid %u) : %s\n", stats->program, stats->pid,
+		stats->halted ? "halted" : running ? "running" : "gone");
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  instructions : %llu\n", (unsigned long long) stats->instructions);
+	fprintf(out, "  PC           : 0x%08x\n", stats->pc);
+	fprintf(out, "  elapsed      : %.1f s\n", stats->seconds);
+	fprintf(out, "  MIPS         : %.3f\n", stats->ips / 1e6);
+	for (int i = 0; i < LIVE_CLASSES; i++) {
+		fprintf(out, "  %-12s : %12llu  (%5.1f%%)\n", CLASS_NAMES[i],
+			(unsigned long long) stats->classes[i], total ? 100.0 * stats->classes[i] / total : 0.0);
+	}
+	fprintf(out, "\n");
+	fflush(out);
+}
+
+/* ----------------------------------------------------------------------------
+	Entry Point
+*/
+
+int main(int argc, char *argv[]) {
+	int interval = 1000, once = 0, remove = 0, opt;
+	const LiveStats *live;
+	LiveStats stats;
+
+	while ((opt = getopt(argc, argv, "i:1u")) != -1) {
+		switch (opt) {
+		case 'i':
+			interval = atoi(optarg);
+			break;
+		case '1':
+			once = 1;
+			break;
+		case 'u':
+			remove = 1;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (optind >= argc || interval <= 0) {
+		usage(argv[0]);
+	}
+
+	if ((live = attach(argv[optind])) == NULL) {
+		fprintf(stderr, "Error: %s is not a simulator statistics segment\n", argv[optind]);
+		return 1;
+	}
+
+	int refresh = !once && isatty(fileno(stdout));
+	while (1) {
+		if (live_read(live, &stats) != 0) {
+			sleep_ms(1);
+			continue;
+		}
+
+		// a run that died without halting leaves its last update behind
+		int running = kill(stats.pid, 0) == 0;
+		display(stdout, &stats, running, refresh);
+
+		if (once || stats.halted || !running) {
+			break;
+		}
+		sleep_ms(interval);
+	}
+
+	if (remove && stats.halted) {
+		shm_unlink(argv[optind]);
+	}
+	return 0;
+}
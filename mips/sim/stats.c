@@ -0,0 +1,131 @@
+/*
+ * stats.c
+ * Instruction-mix execution counters.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "stats.h"
+#include "decode.h"
+
+Stats STATS;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+// loads and stores by access width are derived from the opcode counters;
+// lwc1/swc1 move words and ldc1/sdc1 doublewords
+#define LOADS_BYTE    (STATS.opcode[OPCODE_LB] + STATS.opcode[OPCODE_LBU])
+#define LOADS_HALF    (STATS.opcode[OPCODE_LH] + STATS.opcode[OPCODE_LHU])
+#define LOADS_WORD    (STATS.opcode[OPCODE_LW] + STATS.opcode[OPCODE_LWC1])
+#define LOADS_DOUBLE  (STATS.opcode[OPCODE_LDC1])
+#define STORES_BYTE   (STATS.opcode[OPCODE_SB])
+#define STORES_HALF   (STATS.opcode[OPCODE_SH])
+#define STORES_WORD   (STATS.opcode[OPCODE_SW] + STATS.opcode[OPCODE_SWC1])
+#define STORES_DOUBLE (STATS.opcode[OPCODE_SDC1])
+
+/*
+ * print_table
+ * Print non-zero counters of one dispatch table.
+ */
+static void print_table(FILE *out, const uint64_t *counts, const char **names, uint64_t total) {
+	for (int i = 0; i < DISPATCH_SIZE; i++) {
+		if (counts[i] == 0) {
+			continue;
+		}
+
+		fprintf(out, "  %-12s : %12llu  (%5.1f%%)\n", names[i] ? names[i] : "unrecognized",
+			(unsigned long long) counts[i], total ? 100.0 * counts[i] / total : 0.0);
+	}
+}
+
+/*
+ * json_table
+ * Write one dispatch table as a JSON object keyed by mnemonic.
+ */
+static void json_table(FILE *out, const char *key, const uint64_t *counts, const char **names) {
+	uint64_t unrecognized = 0;
+	int first = 1;
+
+	fprintf(out, "  \"%s\": {", key);
+	for (int i = 0; i < DISPATCH_SIZE; i++) {
+		if (names[i] == NULL) {
+			unrecognized += counts[i];
+			continue;
+		}
+
+		fprintf(out, "%s\"%s\": %llu", first ? "" : ", ", names[i], (unsigned long long) counts[i]);
+		first = 0;
+	}
+	fprintf(out, "%s\"unrecognized\": %llu},\n", first ? "" : ", ", (unsigned long long) unrecognized);
+}
+
+/* ----------------------------------------------------------------------------
+	Reporting
+	See module header file (stats.h) for detailed function comments.
+*/
+
+uint64_t stats_instructions(void) {
+	uint64_t total = 0;
+
+	// every instruction is counted exactly once by opcode
+	for (int i = 0; i < DISPATCH_SIZE; i++) {
+		total += STATS.opcode[i];
+	}
+
+	return total;
+}
+
+uint64_t stats_loads(void) {
+	return LOADS_BYTE + LOADS_HALF + LOADS_WORD + LOADS_DOUBLE;
+}
+
+uint64_t stats_stores(void) {
+	return STORES_BYTE + STORES_HALF + STORES_WORD + STORES_DOUBLE;
+}
+
+void stats_print(FILE *out) {
+	uint64_t total = stats_instructions();
+	uint64_t branches = STATS.branch_taken + STATS.branch_not_taken;
+
+	fprintf(out, "\nInstruction mix :\n");
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "Instructions      : %llu\n", (unsigned long long) total);
+	fprintf(out, "By opcode:\n");
+	print_table(out, STATS.opcode, OPCODE_NAMES, total);
+	fprintf(out, "By function:\n");
+	print_table(out, STATS.function, FUNCTION_NAMES, total);
+	fprintf(out, "By target:\n");
+	print_table(out, STATS.target, TARGET_NAMES, total);
+	fprintf(out, "Branches taken    : %llu (%.1f%%)\n", (unsigned long long) STATS.branch_taken,
+		branches ? 100.0 * STATS.branch_taken / branches : 0.0);
+	fprintf(out, "Branches not taken: %llu\n", (unsigned long long) STATS.branch_not_taken);
+	fprintf(out, "Loads  (b/h/w/d)  : %llu / %llu / %llu / %llu\n", (unsigned long long) LOADS_BYTE,
+		(unsigned long long) LOADS_HALF, (unsigned long long) LOADS_WORD,
+		(unsigned long long) LOADS_DOUBLE);
+	fprintf(out, "Stores (b/h/w/d)  : %llu / %llu / %llu / %llu\n", (unsigned long long) STORES_BYTE,
+		(unsigned long long) STORES_HALF, (unsigned long long) STORES_WORD,
+		(unsigned long long) STORES_DOUBLE);
+	fprintf(out, "\n");
+}
+
+void stats_json(FILE *out) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"instructions\": %llu,\n", (unsigned long long) stats_instructions());
+	json_table(out, "opcode", STATS.opcode, OPCODE_NAMES);
+	json_table(out, "function", STATS.function, FUNCTION_NAMES);
+	json_table(out, "target", STATS.target, TARGET_NAMES);
+	fprintf(out, "  \"branches\": {\"taken\": %llu, \"not_taken\": %llu},\n",
+		(unsigned long long) STATS.branch_taken, (unsigned long long) STATS.branch_not_taken);
+	fprintf(out, "  \"loads\": {\"byte\": %llu, \"half\": %llu, \"word\": %llu, \"double\": %llu},\n",
+		(unsigned long long) LOADS_BYTE, (unsigned long long) LOADS_HALF,
+		(unsigned long long) LOADS_WORD, (unsigned long long) LOADS_DOUBLE);
+	fprintf(out, "  \"stores\": {\"byte\": %llu, \"half\": %llu, \"word\": %llu, \"double\": %llu}\n",
+		(unsigned long long) STORES_BYTE, (unsigned long long) STORES_HALF,
+		(unsigned long long) STORES_WORD, (unsigned long long) STORES_DOUBLE);
+	fprintf(out, "}\n");
+}
@@ -0,0 +1,50 @@
+/*
+ * stats.h
+ * Instruction-mix execution counters.
+ */
+
+#ifndef __STATS_H
+#define __STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+typedef struct Stats_Struct {
+	uint64_t opcode[DISPATCH_SIZE];    // executions per OPCODE_DISPATCH entry
+	uint64_t function[DISPATCH_SIZE];  // executions per FUNCTION_DISPATCH entry
+	uint64_t target[DISPATCH_SIZE];    // executions per TARGET_DISPATCH entry
+	uint64_t branch_taken;             // conditional branches taken
+	uint64_t branch_not_taken;         // conditional branches not taken
+} Stats;
+
+// counters are always on, updated by process_instruction and the branch handlers
+extern Stats STATS;
+
+/*
+ * stats_instructions
+ * Total number of instructions counted.
+ */
+uint64_t stats_instructions(void);
+
+/*
+ * stats_loads, stats_stores
+ * Total number of loads and stores counted, of any width.
+ */
+uint64_t stats_loads(void);
+uint64_t stats_stores(void);
+
+/*
+ * stats_print
+ * Print a human-readable instruction mix report.
+ */
+void stats_print(FILE *out);
+
+/*
+ * stats_json
+ * Write all counters as a JSON object.
+ */
+void stats_json(FILE *out);
+
+#endif // __STATS_H
@@ -0,0 +1,284 @@
+/*
+ * syscalls.c
+ * SPIM/MARS compatible system call emulation.
+ *
+ * Console output is collected in a buffer and written out at halt (or when
+ * the buffer fills, or before the guest reads the console), so programs that
+ * print a character at a time don't cost a host write each. Guest files are
+ * numbered from 3 and mapped to host descriptors through a small table; the
+ * heap grows from the middle of the data region, leaving the lower half for
+ * static data.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "shell.h"
+#include "fpu.h"
+#include "tlb.h"
+#include "syscalls.h"
+
+int EXIT_CODE;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define OUTPUT_SIZE (1 << 16)
+#define MAX_FILES   16
+#define MAX_PATH    256
+
+#define HEAP_START (MEM_DATA_START + MEM_DATA_SIZE / 2)
+#define HEAP_END   (MEM_DATA_START + MEM_DATA_SIZE)
+
+uint32_t HEAP_BREAK = HEAP_START;
+
+// MARS open flags
+#define OPEN_READ   0
+#define OPEN_WRITE  1
+#define OPEN_APPEND 9
+
+static char output[OUTPUT_SIZE];
+static uint32_t output_length;
+
+// host descriptor of each guest file, 0 when closed
+static int files[MAX_FILES];
+
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+#define ARG0 (CURRENT_STATE.REGS[REG_ARG0])
+#define ARG1 (CURRENT_STATE.REGS[REG_ARG1])
+#define ARG2 (CURRENT_STATE.REGS[REG_ARG2])
+
+#define RESULT(value) (NEXT_STATE.REGS[REG_RESULT] = (uint32_t) (value))
+
+// buffered console output, also written by the UART (see syscalls.h)
+void console_write(const void *data, uint32_t length) {
+	if (output_length + length > OUTPUT_SIZE) {
+		syscall_flush();
+		if (length > OUTPUT_SIZE) {
+			fwrite(data, 1, length, stdout);
+			return;
+		}
+	}
+	memcpy(output + output_length, data, length);
+	output_length += length;
+}
+
+// print the NUL-terminated guest string at address
+static void print_string(uint32_t address) {
+	uint32_t available, length;
+	uint8_t *string;
+
+	// with the TLB on, a span ends at the page and the string may go on
+	while ((string = tlb_span(address, &available, 0)) != NULL) {
+		length = strnlen((const char *) string, available);
+		console_write(string, length);
+		if (length < available) {
+			break;
+		}
+		address += available;
+	}
+}
+
+// read console input up to and including a newline, at most length bytes
+static uint32_t read_line(uint8_t *buffer, uint32_t length) {
+	uint32_t count = 0;
+	int c;
+
+	syscall_flush();
+	while (count < length && (c = getchar()) != EOF) {
+		buffer[count++] = c;
+		if (c == '\n') {
+			break;
+		}
+	}
+	return count;
+}
+
+static int open_file(uint32_t path_address, uint32_t flags) {
+	char path[MAX_PATH];
+	uint32_t available;
+	uint8_t *name = tlb_span(path_address, &available, 0);
+	int guest, host, mode;
+
+	if (name == NULL || strnlen((const char *) name, available) >= MAX_PATH) {
+		return -1;
+	}
+	strcpy(path, (const char *) name);
+
+	if (flags == OPEN_READ) {
+		mode = O_RDONLY;
+	} else if (flags == OPEN_WRITE) {
+		mode = O_WRONLY | O_CREAT | O_TRUNC;
+	} else if (flags == OPEN_APPEND) {
+		mode = O_WRONLY | O_CREAT | O_APPEND;
+	} else {
+		return -1;
+	}
+
+	for (guest = 3; guest < MAX_FILES && files[guest]; guest++);
+	if (guest == MAX_FILES || (host = open(path, mode, 0644)) < 0) {
+		return -1;
+	}
+	files[guest] = host;
+	return guest;
+}
+
+// host descriptor of an open guest file, -1 if not open
+static int host_file(uint32_t guest) {
+	return guest >= 3 && guest < MAX_FILES && files[guest] ? files[guest] : -1;
+}
+
+static int read_file(uint32_t guest, uint32_t address, uint32_t length) {
+	uint32_t available;
+	uint8_t *buffer = tlb_span(address, &available, 1);
+
+	if (buffer == NULL || length > available) {
+		return -1;
+	} else if (guest == 0) {
+		return read_line(buffer, length);
+	} else if (host_file(guest) < 0) {
+		return -1;
+	}
+	return read(host_file(guest), buffer, length);
+}
+
+static int write_file(uint32_t guest, uint32_t address, uint32_t length) {
+	uint32_t available;
+	uint8_t *buffer = tlb_span(address, &available, 0);
+
+	if (buffer == NULL || length > available) {
+		return -1;
+	} else if (guest == 1) {
+		console_write(buffer, length);
+		return length;
+	} else if (guest == 2) {
+		// keep ordering with buffered output
+		syscall_flush();
+		return fwrite(buffer, 1, length, stderr);
+	} else if (host_file(guest) < 0) {
+		return -1;
+	}
+	return write(host_file(guest), buffer, length);
+}
+
+static int close_file(uint32_t guest) {
+	if (host_file(guest) < 0) {
+		return -1;
+	}
+	close(files[guest]);
+	files[guest] = 0;
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+	System Call Interface
+	See module header file (syscalls.h) for detailed function comments.
+*/
+
+void syscall_emulate(uint32_t code) {
+	char line[64];
+	uint32_t available;
+	uint8_t *buffer;
+	int64_t next_break;
+	uint64_t bits;
+	float single;
+	double dbl;
+
+	switch (code) {
+	case SYSCALL_PRINT_INT:
+		console_write(line, snprintf(line, sizeof(line), "%d", (int32_t) ARG0));
+		break;
+	case SYSCALL_PRINT_FLOAT:
+		memcpy(&single, &FPU.FPR[FREG_ARG0], sizeof(single));
+		console_write(line, snprintf(line, sizeof(line), "%.9g", single));
+		break;
+	case SYSCALL_PRINT_DOUBLE:
+		bits = FPU.FPR[FREG_ARG0] | ((uint64_t) FPU.FPR[FREG_ARG0 + 1] << 32);
+		memcpy(&dbl, &bits, sizeof(dbl));
+		console_write(line, snprintf(line, sizeof(line), "%.17g", dbl));
+		break;
+	case SYSCALL_PRINT_STRING:
+		print_string(ARG0);
+		break;
+	case SYSCALL_READ_INT:
+		line[read_line((uint8_t *) line, sizeof(line) - 1)] = '\0';
+		RESULT(strtol(line, NULL, 10));
+		break;
+	case SYSCALL_READ_FLOAT:
+		line[read_line((uint8_t *) line, sizeof(line) - 1)] = '\0';
+		single = strtof(line, NULL);
+		memcpy(&FPU.FPR[FREG_RESULT], &single, sizeof(single));
+		break;
+	case SYSCALL_READ_DOUBLE:
+		line[read_line((uint8_t *) line, sizeof(line) - 1)] = '\0';
+		dbl = strtod(line, NULL);
+		memcpy(&bits, &dbl, sizeof(bits));
+		FPU.FPR[FREG_RESULT] = (uint32_t) bits;
+		FPU.FPR[FREG_RESULT + 1] = (uint32_t) (bits >> 32);
+		break;
+	case SYSCALL_READ_STRING:
+		// like fgets: at most length - 1 chars, newline kept, NUL terminated
+		if ((int32_t) ARG1 > 0 && (buffer = tlb_span(ARG0, &available, 1)) != NULL) {
+			uint32_t length = ARG1 < available ? ARG1 : available;
+			buffer[read_line(buffer, length - 1)] = '\0';
+		}
+		break;
+	case SYSCALL_SBRK:
+		// word-aligned growth (or shrinking) within the data region
+		next_break = (int64_t) HEAP_BREAK + (int32_t) ((ARG0 + 3) & ~3u);
+		if (next_break < HEAP_START || next_break > HEAP_END) {
+			RESULT(-1);
+		} else {
+			RESULT(HEAP_BREAK);
+			HEAP_BREAK = next_break;
+		}
+		break;
+	case SYSCALL_EXIT:
+		EXIT_CODE = 0;
+		RUN_BIT = 0;
+		break;
+	case SYSCALL_PRINT_CHAR:
+		line[0] = ARG0;
+		console_write(line, 1);
+		break;
+	case SYSCALL_READ_CHAR:
+		syscall_flush();
+		RESULT(getchar());
+		break;
+	case SYSCALL_OPEN:
+		RESULT(open_file(ARG0, ARG1));
+		break;
+	case SYSCALL_READ:
+		RESULT(read_file(ARG0, ARG1, ARG2));
+		break;
+	case SYSCALL_WRITE:
+		RESULT(write_file(ARG0, ARG1, ARG2));
+		break;
+	case SYSCALL_CLOSE:
+		RESULT(close_file(ARG0));
+		break;
+	case SYSCALL_EXIT2:
+		EXIT_CODE = ARG0;
+		RUN_BIT = 0;
+		break;
+	}
+}
+
+void syscall_flush(void) {
+	if (output_length) {
+		fwrite(output, 1, output_length, stdout);
+		output_length = 0;
+	}
+	fflush(stdout);
+}
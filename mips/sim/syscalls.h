@@ -0,0 +1,37 @@
+/*
+ * syscalls.h
+ * SPIM/MARS compatible system call emulation.
+ */
+
+#ifndef __SYSCALLS_H
+#define __SYSCALLS_H
+
+#include <stdint.h>
+
+// exit code of the guest program, set by the exit syscalls
+extern int EXIT_CODE;
+
+// program break moved by sbrk, within the upper half of the data region
+extern uint32_t HEAP_BREAK;
+
+/*
+ * syscall_emulate
+ * Carry out system call code with arguments from CURRENT_STATE, leaving
+ * results in NEXT_STATE. Unknown codes have no effect.
+ */
+void syscall_emulate(uint32_t code);
+
+/*
+ * console_write
+ * Append guest console output to the buffer. Also used by the UART.
+ */
+void console_write(const void *data, uint32_t length);
+
+/*
+ * syscall_flush
+ * Write out buffered guest console output. Called at halt; reads from the
+ * console flush first so prompts appear before input is read.
+ */
+void syscall_flush(void);
+
+#endif // __SYSCALLS_H
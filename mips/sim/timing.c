@@ -0,0 +1,324 @@
+/*
+ * timing.c
+ * In-order five stage (IF/ID/EX/MEM/WB) pipeline timing model.
+ *
+ * The model runs after each instruction has executed functionally and
+ * tracks, per register, the first cycle in which a consumer may enter EX.
+ * An instruction enters EX one cycle after ID unless an operand is not yet
+ * ready, in which case it holds in ID and the pipeline stalls behind it.
+ * Instruction fetch is assumed to always hit.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mips.h"
+#include "decode.h"
+#include "bpred.h"
+#include "timing.h"
+
+Timing TIMING = {
+	.forwarding     = 1,
+	.mult_latency   = 4,
+	.div_latency    = 32,
+	.branch_penalty = 2,
+	.jump_penalty   = 1,
+};
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+// HI and LO are tracked together as one extra register
+#define REG_HILO  32
+#define REG_NONE  -1
+#define TIMING_REGS 33
+
+// first cycle a consumer of each register may enter EX
+static uint64_t ready[TIMING_REGS];
+
+// whether the pending value of each register comes from a load
+static uint8_t from_load[TIMING_REGS];
+
+// cycle the previous instruction spent in ID
+static uint64_t id_cycle;
+
+// earliest ID cycle of the next instruction after a control penalty
+static uint64_t fetch_ready;
+
+// cycle the (non-pipelined) multiply/divide unit frees up
+static uint64_t muldiv_free;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+/*
+ * registers
+ * Decode the source and destination registers of instr. Also reports
+ * whether it is a load or a multiply/divide, and its latency.
+ */
+static void registers(uint32_t instr, int *src1, int *src2, int *dest,
+		int *load, int *latency) {
+	int op = decode_opcode(instr);
+
+	*src1 = *src2 = *dest = REG_NONE;
+	*load = 0;
+	*latency = 0;
+
+	if (op == OPCODE_SPECIAL) {
+		int func = decode_r_funct(instr);
+		int rs = decode_r_rs(instr), rt = decode_r_rt(instr), rd = decode_r_rd(instr);
+
+		switch (func) {
+		case FUNC_SLL:
+		case FUNC_SRL:
+		case FUNC_SRA:
+			*src1 = rt;
+			*dest = rd;
+			break;
+		case FUNC_JR:
+			*src1 = rs;
+			break;
+		case FUNC_JALR:
+			*src1 = rs;
+			*dest = rd;
+			break;
+		case FUNC_SYSCALL:
+			*src1 = REG_SYSCALL;
+			break;
+		case FUNC_MFHI:
+		case FUNC_MFLO:
+			*src1 = REG_HILO;
+			*dest = rd;
+			break;
+		case FUNC_MTHI:
+		case FUNC_MTLO:
+			*src1 = rs;
+			*dest = REG_HILO;
+			break;
+		case FUNC_MULT:
+		case FUNC_MULTU:
+		case FUNC_DIV:
+		case FUNC_DIVU:
+			*src1 = rs;
+			*src2 = rt;
+			*dest = REG_HILO;
+			*latency = func >= FUNC_DIV ? TIMING.div_latency : TIMING.mult_latency;
+			break;
+		default:
+			*src1 = rs;
+			*src2 = rt;
+			*dest = rd;
+			break;
+		}
+	} else if (op == OPCODE_SPECIAL2) {
+		*src1 = decode_r_rs(instr);
+		*dest = decode_r_rd(instr);
+		if (decode_r_funct(instr) == FUNC2_MUL) {
+			*src2 = decode_r_rt(instr);
+			*latency = TIMING.mult_latency;
+		}
+	} else if (op == OPCODE_SPECIAL3) {
+		int func = decode_r_funct(instr);
+
+		if (func == FUNC3_BSHFL) {
+			*src1 = decode_r_rt(instr);
+			*dest = decode_r_rd(instr);
+		} else {
+			// ext and ins write rt; ins also keeps the bits around its field
+			*src1 = decode_r_rs(instr);
+			*src2 = func == FUNC3_INS ? decode_r_rt(instr) : REG_NONE;
+			*dest = decode_r_rt(instr);
+		}
+	} else if (op == OPCODE_COP0) {
+		int sub = decode_r_rs(instr);
+
+		if (sub == COP0_MF) {
+			*dest = decode_r_rt(instr);
+		} else if (sub == COP0_MT) {
+			*src1 = decode_r_rt(instr);
+		}
+	} else if (op == OPCODE_COP1) {
+		// only moves to and from the integer registers are tracked
+		int sub = decode_r_rs(instr);
+
+		if (sub == COP1_MF || sub == COP1_CF) {
+			*dest = decode_r_rt(instr);
+		} else if (sub == COP1_MT || sub == COP1_CT) {
+			*src1 = decode_r_rt(instr);
+		}
+	} else if (op >= OPCODE_LWC1) {
+		// floating-point loads and stores: only the base is an integer register
+		*src1 = decode_i_rs(instr);
+	} else if (op == OPCODE_REGIMM) {
+		int target = decode_i_rt(instr);
+
+		*src1 = decode_i_rs(instr);
+		if (target == TARGET_BLTZAL || target == TARGET_BGEZAL) {
+			*dest = REG_LINK;
+		}
+	} else if (op == OPCODE_J) {
+		// no registers
+	} else if (op == OPCODE_JAL) {
+		*dest = REG_LINK;
+	} else if (op == OPCODE_BEQ || op == OPCODE_BNE || op >= OPCODE_SB) {
+		// two-source branches and stores
+		*src1 = decode_i_rs(instr);
+		*src2 = decode_i_rt(instr);
+	} else if (op == OPCODE_BLEZ || op == OPCODE_BGTZ) {
+		*src1 = decode_i_rs(instr);
+	} else {
+		// immediate ALU operations and loads
+		*src1 = decode_i_rs(instr);
+		*dest = decode_i_rt(instr);
+		*load = op >= OPCODE_LB;
+	}
+}
+
+/*
+ * control_penalty
+ * Cycles lost fetching down the wrong path after the instruction at pc.
+ */
+static int control_penalty(uint32_t pc, uint32_t instr, uint32_t next_pc) {
+	int op = decode_opcode(instr);
+	int taken = next_pc != pc + 4;
+
+	if (op == OPCODE_J || op == OPCODE_JAL) {
+		return TIMING.jump_penalty;
+	}
+
+	if (op == OPCODE_SPECIAL) {
+		int func = decode_r_funct(instr);
+		if (func != FUNC_JR && func != FUNC_JALR) {
+			return 0;
+		}
+		// returns can be predicted by the return address stack
+		if (func == FUNC_JR && decode_r_rs(instr) == REG_LINK && BPRED_MODELS) {
+			return BPRED_MISPREDICTED ? TIMING.branch_penalty : 0;
+		}
+		return TIMING.branch_penalty;
+	}
+
+	if (op == OPCODE_REGIMM || (op >= OPCODE_BEQ && op <= OPCODE_BGTZ) ||
+			(op == OPCODE_COP1 && decode_r_rs(instr) == COP1_BC)) {
+		if (BPRED_MODELS) {
+			return BPRED_MISPREDICTED ? TIMING.branch_penalty : 0;
+		}
+		// without a predictor, fetch continues sequentially
+		return taken ? TIMING.branch_penalty : 0;
+	}
+
+	return 0;
+}
+
+/* ----------------------------------------------------------------------------
+	Timing Interface
+	See module header file (timing.h) for detailed function comments.
+*/
+
+int timing_configure(const char *spec) {
+	char buf[128];
+	int value;
+
+	snprintf(buf, sizeof(buf), "%s", spec);
+	for (char *item = strtok(buf, ","); item; item = strtok(NULL, ",")) {
+		if (!strcmp(item, "default")) {
+			continue;
+		} else if (!strcmp(item, "forward")) {
+			TIMING.forwarding = 1;
+		} else if (!strcmp(item, "noforward")) {
+			TIMING.forwarding = 0;
+		} else if (sscanf(item, "mult=%d", &value) == 1 && value > 0) {
+			TIMING.mult_latency = value;
+		} else if (sscanf(item, "div=%d", &value) == 1 && value > 0) {
+			TIMING.div_latency = value;
+		} else if (sscanf(item, "branch=%d", &value) == 1 && value >= 0) {
+			TIMING.branch_penalty = value;
+		} else if (sscanf(item, "jump=%d", &value) == 1 && value >= 0) {
+			TIMING.jump_penalty = value;
+		} else {
+			return -1;
+		}
+	}
+
+	TIMING.enabled = 1;
+	return 0;
+}
+
+void timing_retire(uint32_t pc, uint32_t instr, uint32_t next_pc) {
+	int src[2], dest, load, latency;
+
+	registers(instr, &src[0], &src[1], &dest, &load, &latency);
+
+	uint64_t id = id_cycle + 1 > fetch_ready ? id_cycle + 1 : fetch_ready;
+	uint64_t ex = id + 1;
+	int cause = REG_NONE;
+
+	// hold in ID until every operand can be forwarded or read
+	for (int i = 0; i < 2; i++) {
+		if (src[i] > 0 && ready[src[i]] > ex) {
+			ex = ready[src[i]];
+			cause = src[i];
+		}
+	}
+	if (latency && muldiv_free > ex) {
+		ex = muldiv_free;
+		cause = REG_HILO;
+	}
+
+	uint64_t stall = ex - (id + 1);
+	if (stall) {
+		if (cause == REG_HILO) {
+			TIMING.muldiv_stalls += stall;
+		} else if (from_load[cause] && TIMING.forwarding) {
+			TIMING.load_use_stalls += stall;
+		} else {
+			TIMING.data_stalls += stall;
+		}
+	}
+
+	// results forward from the end of EX (MEM for loads), or are read in
+	// ID once written back in the first half of WB
+	if (dest > 0) {
+		if (latency) {
+			ready[dest] = ex + latency;
+			muldiv_free = ex + latency;
+		} else {
+			ready[dest] = ex + (load ? 2 : 1);
+		}
+		if (!TIMING.forwarding) {
+			ready[dest] += latency ? 2 : (load ? 1 : 2);
+		}
+		from_load[dest] = load;
+	}
+
+	id_cycle = ex - 1;
+	fetch_ready = id_cycle + 1 + control_penalty(pc, instr, next_pc);
+	TIMING.branch_stalls += fetch_ready - (id_cycle + 1);
+
+	// the last instruction leaves WB two cycles after EX
+	TIMING.cycles = ex + 3;
+	TIMING.instructions++;
+}
+
+void timing_report(FILE *out) {
+	if (!TIMING.enabled) {
+		return;
+	}
+
+	fprintf(out, "\nPipeline timing (forwarding %s, mult %d, div %d, branch penalty %d, jump penalty %d) :\n",
+		TIMING.forwarding ? "on" : "off", TIMING.mult_latency, TIMING.div_latency,
+		TIMING.branch_penalty, TIMING.jump_penalty);
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "Instructions     : %llu\n", (unsigned long long) TIMING.instructions);
+	fprintf(out, "Cycles           : %llu\n", (unsigned long long) TIMING.cycles);
+	fprintf(out, "CPI              : %.3f\n",
+		TIMING.instructions ? (double) TIMING.cycles / TIMING.instructions : 0.0);
+	fprintf(out, "Data stalls      : %llu\n", (unsigned long long) TIMING.data_stalls);
+	fprintf(out, "Load-use stalls  : %llu\n", (unsigned long long) TIMING.load_use_stalls);
+	fprintf(out, "Mult/div stalls  : %llu\n", (unsigned long long) TIMING.muldiv_stalls);
+	fprintf(out, "Branch penalties : %llu\n\n", (unsigned long long) TIMING.branch_stalls);
+}
@@ -0,0 +1,55 @@
+/*
+ * timing.h
+ * In-order five stage (IF/ID/EX/MEM/WB) pipeline timing model.
+ */
+
+#ifndef __TIMING_H
+#define __TIMING_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct Timing_Struct {
+	int enabled;
+
+	// configuration
+	int forwarding;       // EX/MEM and MEM/WB bypasses present
+	int mult_latency;     // cycles until HI/LO are ready after mult/multu
+	int div_latency;      // cycles until HI/LO are ready after div/divu
+	int branch_penalty;   // cycles lost on a mispredicted (or taken) branch
+	int jump_penalty;     // cycles lost on j/jal, resolved in ID
+
+	// results
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t data_stalls;
+	uint64_t load_use_stalls;
+	uint64_t muldiv_stalls;
+	uint64_t branch_stalls;
+} Timing;
+
+extern Timing TIMING;
+
+/*
+ * timing_configure
+ * Enable the timing model from a comma separated spec of forward,
+ * noforward, mult=N, div=N, branch=N and jump=N (or "default").
+ * Returns 0 on success, -1 on a malformed spec.
+ */
+int timing_configure(const char *spec);
+
+/*
+ * timing_retire
+ * Advance the pipeline by one instruction, charging hazard stalls and
+ * control penalties. Branch penalties are charged on mispredictions when
+ * branch predictors are enabled and on taken branches otherwise.
+ */
+void timing_retire(uint32_t pc, uint32_t instr, uint32_t next_pc);
+
+/*
+ * timing_report
+ * Print cycles, CPI and the stall breakdown.
+ */
+void timing_report(FILE *out);
+
+#endif // __TIMING_H
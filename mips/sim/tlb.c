@@ -0,0 +1,226 @@
+/*
+ * tlb.c
+ * MIPS32 TLB and address translation, enabled with -V.
+ *
+ * The loads, stores and instruction fetch translate through the micro-TLB,
+ * a direct-mapped cache of 4K page translations, and fall back to
+ * searching the TLB on a miss. The micro-TLB holds physical addresses
+ * rather than host pointers: the page table (MEM_PAGES) turns those into
+ * host memory in one more lookup, and stays right when simt swaps lane
+ * memory or shared text is copied on write. It is emptied whenever a TLB
+ * entry or the ASID changes. It keeps separate entries for kernel and user
+ * mode, so mode changes need no flush, and for fetches, loads and stores,
+ * so a loop's code and data pages never evict each other.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sim.h"
+#include "mips.h"
+#include "shell.h"
+#include "cp0.h"
+#include "tlb.h"
+
+MicroTlbEntry MICRO_TLB[2][TLB_ACCESSES][MICRO_TLB_SIZE];
+
+int TLB_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+typedef struct {
+	uint32_t mask;   // PageMask
+	uint32_t hi;     // EntryHi: VPN2 and ASID
+	uint32_t lo[2];  // EntryLo0 and EntryLo1, for the even and odd page
+	int global;      // G was set in both EntryLo registers
+} TlbEntry;
+
+static TlbEntry tlb[TLB_ENTRIES];
+
+// translation failures reported by walk, beside the exception code
+#define WALK_OK     -1
+#define WALK_REFILL 0x100  // no entry matched
+
+static uint64_t lookups;
+static uint64_t refills;
+static uint64_t writes;
+
+static int kernel_mode(void) {
+	return (CP0.REGS[CP0_STATUS] & (STATUS_UM | STATUS_EXL | STATUS_ERL)) != STATUS_UM;
+}
+
+/*
+ * match
+ * TLB entry mapping the virtual page pair of address in address space
+ * asid, or -1.
+ */
+static int match(uint32_t address, uint32_t asid) {
+	for (int i = 0; i < TLB_ENTRIES; i++) {
+		if (((address ^ tlb[i].hi) & ENTRYHI_VPN2 & ~tlb[i].mask) == 0 &&
+			(tlb[i].global || (tlb[i].hi & ENTRYHI_ASID) == asid)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ * walk
+ * Translate address for access in the current mode and address space,
+ * setting the physical address and the size of the page it is on. Returns
+ * WALK_OK, or the exception code to raise (with WALK_REFILL for a refill).
+ */
+static int walk(uint32_t address, int access, uint32_t *physical, uint32_t *page_size) {
+	int load_code = access == TLB_STORE ? EXC_ADES : EXC_ADEL;
+	int tlb_code = access == TLB_STORE ? EXC_TLBS : EXC_TLBL;
+
+	if (address >= KSEG0_START && !kernel_mode()) {
+		return load_code;
+	}
+
+	// kseg0 and kseg1 are unmapped
+	if (address >= KSEG0_START && address < KSEG2_START) {
+		*physical = address;
+		*page_size = 1 << MICRO_PAGE_BITS;
+		return WALK_OK;
+	}
+
+	int i = match(address, CP0.REGS[CP0_ENTRYHI] & ENTRYHI_ASID);
+	if (i < 0) {
+		return tlb_code | WALK_REFILL;
+	}
+
+	// the pair is split in half by the lowest bit above the page offset
+	uint32_t size = ((tlb[i].mask | ~ENTRYHI_VPN2) + 1) >> 1;
+	uint32_t lo = tlb[i].lo[(address & size) != 0];
+
+	if (!(lo & ENTRYLO_V)) {
+		return tlb_code;
+	} else if (access == TLB_STORE && !(lo & ENTRYLO_D)) {
+		return EXC_MOD;
+	}
+
+	*physical = (((lo & ENTRYLO_PFN) >> ENTRYLO_SHIFT_PFN) << MICRO_PAGE_BITS & ~(size - 1)) | (address & (size - 1));
+	*page_size = size;
+	return WALK_OK;
+}
+
+/* ----------------------------------------------------------------------------
+	TLB Interface
+	See module header file (tlb.h) for detailed function comments.
+*/
+
+void tlb_enable(void) {
+	// distinct pairs in kseg0, which is never looked up, so no two entries match
+	for (int i = 0; i < TLB_ENTRIES; i++) {
+		tlb[i] = (TlbEntry) { .hi = KSEG0_START + (i << 13) };
+	}
+	tlb_flush();
+	TLB_ENABLED = TRUE;
+}
+
+int tlb_lookup(uint32_t *address, int access) {
+	uint32_t physical, page_size;
+	int result = walk(*address, access, &physical, &page_size);
+
+	lookups++;
+	if (result != WALK_OK && (result & WALK_REFILL)) {
+		refills++;
+		return exception_raise_refill(result & ~WALK_REFILL, *address);
+	} else if (result != WALK_OK) {
+		return exception_raise(result, *address);
+	}
+
+	uint32_t vpn = *address >> MICRO_PAGE_BITS;
+	MICRO_TLB[kernel_mode()][access][MICRO_TLB_INDEX(vpn)] =
+		(MicroTlbEntry) { vpn, physical & ~((1 << MICRO_PAGE_BITS) - 1) };
+
+	*address = physical;
+	return STATUS_OK;
+}
+
+uint8_t *tlb_span(uint32_t address, uint32_t *available, int writable) {
+	uint32_t physical, page_size;
+	uint8_t *span;
+
+	if (!TLB_ENABLED) {
+		return mem_span(address, available, writable);
+	}
+
+	if (walk(address, writable ? TLB_STORE : TLB_LOAD, &physical, &page_size) != WALK_OK ||
+		(span = mem_span(physical, available, writable)) == NULL) {
+		return NULL;
+	}
+
+	// the next page may be mapped anywhere
+	uint32_t left = page_size - (address & (page_size - 1));
+	if (*available > left) {
+		*available = left;
+	}
+	return span;
+}
+
+void tlb_operation(int func) {
+	uint32_t asid = CP0.REGS[CP0_ENTRYHI] & ENTRYHI_ASID;
+	TlbEntry *entry;
+	int i;
+
+	switch (func) {
+	case FUNC_CO_TLBR:
+		entry = &tlb[CP0.REGS[CP0_INDEX] % TLB_ENTRIES];
+		CP0.REGS[CP0_PAGEMASK] = entry->mask;
+		CP0.REGS[CP0_ENTRYHI] = entry->hi;
+		CP0.REGS[CP0_ENTRYLO0] = entry->lo[0] | (entry->global ? ENTRYLO_G : 0);
+		CP0.REGS[CP0_ENTRYLO1] = entry->lo[1] | (entry->global ? ENTRYLO_G : 0);
+		if ((entry->hi & ENTRYHI_ASID) != asid) {
+			tlb_flush();
+		}
+		break;
+	case FUNC_CO_TLBWI:
+	case FUNC_CO_TLBWR:
+		i = func == FUNC_CO_TLBWI ? CP0.REGS[CP0_INDEX] % TLB_ENTRIES : tlb_random();
+		entry = &tlb[i];
+		entry->mask = CP0.REGS[CP0_PAGEMASK] & PAGEMASK_MASK;
+		entry->hi = CP0.REGS[CP0_ENTRYHI] & ((ENTRYHI_VPN2 & ~entry->mask) | ENTRYHI_ASID);
+		entry->lo[0] = CP0.REGS[CP0_ENTRYLO0] & ~ENTRYLO_G;
+		entry->lo[1] = CP0.REGS[CP0_ENTRYLO1] & ~ENTRYLO_G;
+		entry->global = CP0.REGS[CP0_ENTRYLO0] & CP0.REGS[CP0_ENTRYLO1] & ENTRYLO_G;
+		writes++;
+		tlb_flush();
+		break;
+	case FUNC_CO_TLBP:
+		i = match(CP0.REGS[CP0_ENTRYHI], asid);
+		CP0.REGS[CP0_INDEX] = i < 0 ? INDEX_P : (uint32_t) i;
+		break;
+	}
+}
+
+uint32_t tlb_random(void) {
+	uint32_t wired = CP0.REGS[CP0_WIRED];
+
+	// counts down with each instruction, wrapping from Wired to the last entry
+	if (wired >= TLB_ENTRIES - 1) {
+		return TLB_ENTRIES - 1;
+	}
+	return TLB_ENTRIES - 1 - INSTRUCTION_COUNT % (TLB_ENTRIES - wired);
+}
+
+void tlb_flush(void) {
+	memset(MICRO_TLB, 0xFF, sizeof(MICRO_TLB));
+}
+
+void tlb_report(FILE *out) {
+	if (!TLB_ENABLED) {
+		return;
+	}
+
+	fprintf(out, "\nTLB :\n");
+	fprintf(out, "-------------------------------------\n");
+	fprintf(out, "  %-28s : %12llu\n", "micro-TLB misses", (unsigned long long) lookups);
+	fprintf(out, "  %-28s : %12llu\n", "refills", (unsigned long long) refills);
+	fprintf(out, "  %-28s : %12llu\n", "entries written", (unsigned long long) writes);
+	fprintf(out, "\n");
+}
@@ -0,0 +1,119 @@
+/*
+ * tlb.h
+ * MIPS32 TLB and address translation, enabled with -V.
+ *
+ * kuseg (below KSEG0_START) and kseg2/kseg3 (from KSEG2_START) are mapped
+ * through a fully associative TLB of even/odd page pairs, with page sizes
+ * from 4K set by PageMask. kseg0 and kseg1 are unmapped: they address the
+ * memory map directly rather than aliasing low physical memory, since the
+ * kernel text, kernel data and devices are already placed there. Only
+ * kernel mode may use them, or kseg2/kseg3.
+ *
+ * Physical addresses are the addresses of the memory map, so the program
+ * loaders, devices and DMA are unaffected by the TLB.
+ */
+
+#ifndef __TLB_H
+#define __TLB_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "cp0.h"
+
+#define TLB_ENTRIES 16
+
+#define KSEG0_START 0x80000000
+#define KSEG2_START 0xC0000000
+
+// kinds of access, which choose the exception a failed translation raises
+// and the micro-TLB array the translation is cached in
+#define TLB_LOAD     0
+#define TLB_STORE    1
+#define TLB_FETCH    2  // instruction fetch, faults like a load
+#define TLB_ACCESSES 3
+
+// the micro-TLB caches translations of 4K pages, by mode and kind of access
+#define MICRO_TLB_SIZE  64
+#define MICRO_PAGE_BITS 12
+
+// micro-TLB slot of a virtual page; folding in the higher bits keeps the
+// 64K-aligned region bases (text, data, stack) out of each other's slot
+#define MICRO_TLB_INDEX(vpn) (((vpn) ^ ((vpn) >> 6)) % MICRO_TLB_SIZE)
+
+typedef struct {
+	uint32_t vpn;   // virtual page number, ~0 when empty
+	uint32_t base;  // physical address of the page
+} MicroTlbEntry;
+
+extern MicroTlbEntry MICRO_TLB[2][TLB_ACCESSES][MICRO_TLB_SIZE];
+
+// whether addresses are translated, set by tlb_enable
+extern int TLB_ENABLED;
+
+/*
+ * tlb_enable
+ * Turn translation on, with every TLB entry invalid.
+ */
+void tlb_enable(void);
+
+/*
+ * tlb_lookup
+ * Translate through the TLB, filling the micro-TLB. See tlb_translate.
+ */
+int tlb_lookup(uint32_t *address, int access);
+
+/*
+ * tlb_translate
+ * Replace the virtual address of a load (access = TLB_LOAD), store
+ * (TLB_STORE) or instruction fetch (TLB_FETCH) with its physical address. If it can't be translated,
+ * raise the address error or TLB exception and return STATUS_ERR, for
+ * handlers to return; otherwise return STATUS_OK.
+ */
+static inline int tlb_translate(uint32_t *address, int access) {
+	uint32_t vpn = *address >> MICRO_PAGE_BITS;
+	int kernel = (CP0.REGS[CP0_STATUS] & (STATUS_UM | STATUS_EXL | STATUS_ERL)) != STATUS_UM;
+	MicroTlbEntry *entry = &MICRO_TLB[kernel][access][MICRO_TLB_INDEX(vpn)];
+
+	if (entry->vpn == vpn) {
+		*address = entry->base | (*address & ((1 << MICRO_PAGE_BITS) - 1));
+		return STATUS_OK;
+	}
+	return tlb_lookup(address, access);
+}
+
+/*
+ * tlb_span
+ * mem_span for a guest virtual address, for system calls and native
+ * routines: translated without raising exceptions (NULL if it can't be)
+ * and ending at the end of the page. The same as mem_span with the TLB off.
+ */
+uint8_t *tlb_span(uint32_t address, uint32_t *available, int writable);
+
+/*
+ * tlb_operation
+ * Carry out tlbr, tlbwi, tlbwr or tlbp, by FUNC_CO code.
+ */
+void tlb_operation(int func);
+
+/*
+ * tlb_random
+ * Current value of the Random register, an index between Wired and the
+ * last entry.
+ */
+uint32_t tlb_random(void);
+
+/*
+ * tlb_flush
+ * Forget recent translations, when the address space (EntryHi ASID) changes.
+ */
+void tlb_flush(void);
+
+/*
+ * tlb_report
+ * Print TLB statistics, if translation is on.
+ */
+void tlb_report(FILE *out);
+
+#endif // __TLB_H
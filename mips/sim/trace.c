@@ -0,0 +1,182 @@
+/*
+ * trace.c
+ * Event tracing with Chrome trace format export.
+ *
+ * Events are appended to a buffer allocated up front, timestamped with the
+ * guest instruction count, and only formatted at export. Calls and phases
+ * go on separate tracks so guest phase markers never break call nesting.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "shell.h"
+#include "trace.h"
+
+int TRACE_ENABLED;
+
+/* ----------------------------------------------------------------------------
+	Local State
+*/
+
+#define EVENT_CALL        0
+#define EVENT_RETURN      1
+#define EVENT_SYSCALL     2
+#define EVENT_PHASE_BEGIN 3
+#define EVENT_PHASE_END   4
+#define EVENT_HALT        5
+
+// trace tracks (Chrome thread ids)
+#define TRACK_CALLS  1
+#define TRACK_PHASES 2
+
+typedef struct {
+	uint64_t ts;
+	uint32_t a;
+	uint32_t b;
+	uint32_t type;
+} Event;
+
+static Event *events;
+static uint32_t capacity, count;
+static uint64_t dropped;
+
+// open spans, so unmatched returns are ignored and open spans closed at halt
+static uint32_t call_depth, phase_depth;
+
+/* ----------------------------------------------------------------------------
+	Local Helpers
+*/
+
+static void record(uint32_t type, uint32_t a, uint32_t b) {
+	// the buffer has one slot beyond capacity, kept for the halt event
+	if (count >= capacity && type != EVENT_HALT) {
+		dropped++;
+		return;
+	}
+
+	Event *event = &events[count++];
+	event->ts = INSTRUCTION_COUNT;
+	event->type = type;
+	event->a = a;
+	event->b = b;
+}
+
+// span begin (named after id) or end event on a track
+static void write_span(FILE *out, int begin, const char *cat, uint32_t id,
+		uint64_t ts, int track) {
+	if (begin) {
+		fprintf(out, cat[0] == 'p' ? ",\n{\"name\": \"phase %u\", " : ",\n{\"name\": \"0x%08x\", ", id);
+	} else {
+		fprintf(out, ",\n{");
+	}
+	fprintf(out, "\"cat\": \"%s\", \"ph\": \"%s\", \"ts\": %llu, \"pid\": 1, \"tid\": %d}",
+		cat, begin ? "B" : "E", (unsigned long long) ts, track);
+}
+
+/* ----------------------------------------------------------------------------
+	Trace Interface
+	See module header file (trace.h) for detailed function comments.
+*/
+
+int trace_enable(uint32_t size) {
+	if ((events = malloc(((size_t) size + 1) * sizeof(Event))) == NULL) {
+		return -1;
+	}
+	capacity = size;
+	TRACE_ENABLED = 1;
+	return 0;
+}
+
+void trace_call(uint32_t entry) {
+	call_depth++;
+	record(EVENT_CALL, entry, 0);
+}
+
+void trace_return(void) {
+	if (call_depth) {
+		call_depth--;
+		record(EVENT_RETURN, 0, 0);
+	}
+}
+
+void trace_syscall(uint32_t code, uint32_t arg) {
+	record(EVENT_SYSCALL, code, arg);
+}
+
+void trace_phase(int begin, uint32_t id) {
+	if (begin) {
+		phase_depth++;
+		record(EVENT_PHASE_BEGIN, id, 0);
+	} else if (phase_depth) {
+		phase_depth--;
+		record(EVENT_PHASE_END, id, 0);
+	}
+}
+
+int trace_export(const char *filename) {
+	FILE *out;
+	uint64_t end = INSTRUCTION_COUNT;
+
+	if (!TRACE_ENABLED || (out = fopen(filename, "w")) == NULL) {
+		return -1;
+	}
+
+	record(EVENT_HALT, 0, 0);
+
+	fprintf(out, "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"clock\": "
+		"\"guest instructions\", \"dropped_events\": %llu},\n\"traceEvents\": [\n",
+		(unsigned long long) dropped);
+	fprintf(out, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+		"\"args\": {\"name\": \"calls\"}}", TRACK_CALLS);
+	fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+		"\"args\": {\"name\": \"phases\"}}", TRACK_PHASES);
+
+	uint32_t open_calls = 0, open_phases = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		Event *event = &events[i];
+
+		switch (event->type) {
+		case EVENT_CALL:
+			write_span(out, 1, "call", event->a, event->ts, TRACK_CALLS);
+			open_calls++;
+			break;
+		case EVENT_RETURN:
+			write_span(out, 0, "call", 0, event->ts, TRACK_CALLS);
+			open_calls--;
+			break;
+		case EVENT_PHASE_BEGIN:
+			write_span(out, 1, "phase", event->a, event->ts, TRACK_PHASES);
+			open_phases++;
+			break;
+		case EVENT_PHASE_END:
+			write_span(out, 0, "phase", event->a, event->ts, TRACK_PHASES);
+			open_phases--;
+			break;
+		case EVENT_SYSCALL:
+			fprintf(out, ",\n{\"name\": \"syscall %u\", \"cat\": \"syscall\", \"ph\": \"i\", "
+				"\"s\": \"t\", \"ts\": %llu, \"pid\": 1, \"tid\": %d, \"args\": "
+				"{\"v0\": %u, \"a0\": %u}}", event->a, (unsigned long long) event->ts,
+				TRACK_CALLS, event->a, event->b);
+			break;
+		case EVENT_HALT:
+			fprintf(out, ",\n{\"name\": \"halt\", \"cat\": \"halt\", \"ph\": \"i\", "
+				"\"s\": \"g\", \"ts\": %llu, \"pid\": 1, \"tid\": %d}",
+				(unsigned long long) event->ts, TRACK_CALLS);
+			break;
+		}
+	}
+
+	// close whatever was still open when the buffer ended
+	while (open_calls--) {
+		write_span(out, 0, "call", 0, end, TRACK_CALLS);
+	}
+	while (open_phases--) {
+		write_span(out, 0, "phase", 0, end, TRACK_PHASES);
+	}
+
+	fprintf(out, "\n]}\n");
+	fclose(out);
+	return 0;
+}
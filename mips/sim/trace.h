@@ -0,0 +1,59 @@
+/*
+ * trace.h
+ * Event tracing with Chrome trace format export.
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <stdint.h>
+
+// whether events are being recorded
+extern int TRACE_ENABLED;
+
+// record a syscall with its code and first argument
+#define TRACE_SYSCALL(code, arg) do {                                   \
+		if (TRACE_ENABLED) trace_syscall((code), (arg));                \
+	} while (0)
+
+/*
+ * trace_enable
+ * Preallocate a buffer of capacity events and start recording. Events past
+ * the capacity are dropped and counted, but the halt event is always kept.
+ * Returns 0 on success.
+ */
+int trace_enable(uint32_t capacity);
+
+/*
+ * trace_call
+ * Open a span for a call into the function at entry.
+ */
+void trace_call(uint32_t entry);
+
+/*
+ * trace_return
+ * Close the innermost open call span.
+ */
+void trace_return(void);
+
+/*
+ * trace_syscall
+ * Record a syscall instant event.
+ */
+void trace_syscall(uint32_t code, uint32_t arg);
+
+/*
+ * trace_phase
+ * Open (begin set) or close the guest phase span numbered id.
+ */
+void trace_phase(int begin, uint32_t id);
+
+/*
+ * trace_export
+ * Record the halt, close any open spans and write the buffer as Chrome
+ * trace JSON (also read by Perfetto). Timestamps are guest instruction
+ * counts. Returns 0 on success.
+ */
+int trace_export(const char *filename);
+
+#endif // __TRACE_H